@@ -0,0 +1,263 @@
+#include <benchmark/benchmark.h>
+#include "memory-pool/memory_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    // Big enough for one batch of any workload. Single-threaded runs reset the pool after every batch.
+    constexpr size_t batchCapacity = 64 * MB;
+
+    // Threads share one resource that can't be reset while they run, so threaded runs take a fixed number of
+    // batches and reserve room for all of them.
+    constexpr size_t sharedCapacity = 4096 * MB;
+    constexpr int threadedIterations = 128;
+
+    enum class workload {
+        Small,
+        Large,
+        Mixed,
+        Aligned
+    };
+
+    struct request {
+        size_t size;
+        size_t alignment;
+    };
+
+    // The requests one batch makes, in order. The same for every allocator.
+    std::vector<request> makeRequests(const workload kind) {
+        std::minstd_rand random(42);
+        std::vector<request> ret;
+        switch (kind) {
+            case workload::Small:
+                ret.assign(1024, {16, alignof(std::max_align_t)});
+                break;
+            case workload::Large:
+                ret.assign(64, {64 * 1024, alignof(std::max_align_t)});
+                break;
+            case workload::Mixed:
+                // Mostly small, occasionally up to 1 KiB, and rarely a multiple of the alignment.
+                for (int i = 0; i < 1024; ++i) {
+                    const size_t size = (static_cast<size_t>(8) << random() % 8) - random() % 8;
+                    ret.push_back({size, alignof(std::max_align_t)});
+                }
+                break;
+            case workload::Aligned:
+                for (int i = 0; i < 1024; ++i) {
+                    ret.push_back({48, static_cast<size_t>(16) << random() % 9});
+                }
+                break;
+        }
+        return ret;
+    }
+
+    std::string workloadName(const workload kind) {
+        switch (kind) {
+            case workload::Small:
+                return "Small";
+            case workload::Large:
+                return "Large";
+            case workload::Mixed:
+                return "Mixed";
+            case workload::Aligned:
+                return "Aligned";
+        }
+        return "Unknown";
+    }
+
+    // The C allocator, as a memory resource.
+    class malloc_resource : public std::pmr::memory_resource {
+        void* do_allocate(const size_t bytes, const size_t alignment) override {
+            if (alignment <= alignof(std::max_align_t)) {
+                return std::malloc(bytes);
+            }
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+
+        void do_deallocate(void* p, size_t, const size_t alignment) override {
+            if (alignment <= alignof(std::max_align_t)) {
+                std::free(p);
+            } else {
+                ::operator delete(p, std::align_val_t(alignment));
+            }
+        }
+
+        [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    struct subject {
+        std::string name;
+        std::unique_ptr<std::pmr::memory_resource> (*create)(size_t capacity);
+    };
+
+    template<pool_type Type>
+    std::unique_ptr<std::pmr::memory_resource> createPool(const size_t capacity) {
+        return std::unique_ptr<std::pmr::memory_resource>(pool::create(capacity, Type));
+    }
+
+    std::unique_ptr<std::pmr::memory_resource> createMalloc(size_t) {
+        return std::make_unique<malloc_resource>();
+    }
+
+    std::unique_ptr<std::pmr::memory_resource> createMonotonic(size_t) {
+        return std::make_unique<std::pmr::monotonic_buffer_resource>();
+    }
+
+    std::unique_ptr<std::pmr::memory_resource> createUnsynchronizedPool(size_t) {
+        return std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    }
+
+    std::unique_ptr<std::pmr::memory_resource> createSynchronizedPool(size_t) {
+        return std::make_unique<std::pmr::synchronized_pool_resource>();
+    }
+
+    const subject poolSubjects[] = {
+        {"SingleThreaded", createPool<pool_type::SingleThreaded>},
+        {"ThreadSafe", createPool<pool_type::ThreadSafe>},
+        {"ThreadBuffered", createPool<pool_type::ThreadBuffered>},
+        {"PerCpu", createPool<pool_type::PerCpu>},
+        {"PerThread", createPool<pool_type::PerThread>},
+        {"Locked", createPool<pool_type::Locked>},
+        {"Recycling", createPool<pool_type::Recycling>},
+    };
+
+    // Frees everything a batch allocated that deallocating didn't, the way a user of each resource would.
+    void endBatch(std::pmr::memory_resource& resource) {
+        if (auto* memoryPool = dynamic_cast<pool*>(&resource)) {
+            memoryPool->reset();
+        } else if (auto* monotonic = dynamic_cast<std::pmr::monotonic_buffer_resource*>(&resource)) {
+            monotonic->release();
+        }
+    }
+
+    uint64_t pageFaults() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PageFaultCount;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_minflt + usage.ru_majflt;
+#endif
+    }
+
+    // Makes the batch's allocations, writing to each, then deallocates them in reverse.
+    void runBatch(std::pmr::memory_resource& resource, const std::vector<request>& requests,
+                  std::vector<void*>& allocations) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            allocations[i] = resource.allocate(requests[i].size, requests[i].alignment);
+            *static_cast<volatile char*>(allocations[i]) = 1;
+        }
+        for (size_t i = requests.size(); i-- > 0;) {
+            resource.deallocate(allocations[i], requests[i].size, requests[i].alignment);
+        }
+    }
+
+    std::pmr::memory_resource* sharedResource;
+    std::unique_ptr<std::pmr::memory_resource> ownedResource;
+    uint64_t faultsBefore;
+    pool_metrics metricsBefore;
+
+    void allocate(benchmark::State& state, const subject& allocator, const workload kind, const bool shared) {
+        const auto requests = makeRequests(kind);
+        std::vector<void*> allocations(requests.size());
+        if (state.thread_index() == 0) {
+            ownedResource = allocator.create(shared ? sharedCapacity : batchCapacity);
+            sharedResource = ownedResource.get();
+            // Warm up, so one-time setup like reserving and first commits doesn't count.
+            runBatch(*sharedResource, requests, allocations);
+            endBatch(*sharedResource);
+            faultsBefore = pageFaults();
+            metricsBefore = pool::get_metrics();
+        }
+        for (auto _ : state) {
+            runBatch(*sharedResource, requests, allocations);
+            if (!shared) {
+                endBatch(*sharedResource);
+            }
+        }
+        const auto allocationCount = static_cast<double>(state.iterations() * requests.size());
+        state.SetItemsProcessed(static_cast<int64_t>(allocationCount));
+        if (state.thread_index() == 0) {
+            // Page faults and commits are counted process-wide, so report them once, per million allocations
+            // across all threads.
+            const auto totalAllocations = allocationCount * state.threads();
+            state.counters["faults/M"] = static_cast<double>(pageFaults() - faultsBefore) * 1e6 / totalAllocations;
+            const auto metrics = pool::get_metrics();
+            if (metrics.enabled && dynamic_cast<pool*>(sharedResource) != nullptr) {
+                state.counters["syscalls/M"] =
+                    static_cast<double>(metrics.commits - metricsBefore.commits) * 1e6 / totalAllocations;
+            }
+            ownedResource.reset();
+            sharedResource = nullptr;
+        }
+    }
+
+    void registerSingleThreaded(const subject& allocator) {
+        for (const auto kind : {workload::Small, workload::Large, workload::Mixed, workload::Aligned}) {
+            const auto name = "BM_Allocate_" + workloadName(kind) + "/" + allocator.name;
+            benchmark::RegisterBenchmark(name.c_str(), [&allocator, kind](benchmark::State& state) {
+                allocate(state, allocator, kind, false);
+            });
+        }
+    }
+
+    // Sweeps from one thread to one per hardware thread, all sharing one resource.
+    void registerThreaded(const subject& allocator) {
+        const auto maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (const auto kind : {workload::Small, workload::Mixed}) {
+            const auto name = "BM_AllocateShared_" + workloadName(kind) + "/" + allocator.name;
+            benchmark::RegisterBenchmark(name.c_str(), [&allocator, kind](benchmark::State& state) {
+                allocate(state, allocator, kind, true);
+            })
+                    ->ThreadRange(1, maxThreads)
+                    ->Iterations(threadedIterations)
+                    ->UseRealTime();
+        }
+    }
+
+    [[maybe_unused]] const bool registered = [] {
+        static const subject mallocSubject{"Malloc", createMalloc};
+        static const subject monotonicSubject{"Monotonic", createMonotonic};
+        static const subject unsynchronizedSubject{"UnsynchronizedPool", createUnsynchronizedPool};
+        static const subject synchronizedSubject{"SynchronizedPool", createSynchronizedPool};
+
+        registerSingleThreaded(mallocSubject);
+        registerSingleThreaded(monotonicSubject);
+        registerSingleThreaded(unsynchronizedSubject);
+        for (const auto& allocator : poolSubjects) {
+            registerSingleThreaded(allocator);
+        }
+
+        // Only resources that are safe to share between threads.
+        registerThreaded(mallocSubject);
+        registerThreaded(synchronizedSubject);
+        for (const auto& allocator : poolSubjects) {
+            if (allocator.name != "SingleThreaded") {
+                registerThreaded(allocator);
+            }
+        }
+        return true;
+    }();
+}
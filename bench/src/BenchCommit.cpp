@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+#include "memory-pool/memory_pool.h"
+#include <cstring>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+    constexpr size_t capacity = 256 * MB;
+    constexpr size_t chunkSize = 4096;
+
+    pool_options commitOptions(const commit_mode mode, const size_t prefaultBytes) {
+        pool_options options;
+        options.commitMode = mode;
+        options.prefaultBytes = prefaultBytes;
+        return options;
+    }
+
+    // Creates a pool, fills the given number of bytes with page-sized chunks, writing each, and destroys it.
+    void fillPool(benchmark::State& state, const pool_type type, const pool_options& options) {
+        const auto bytes = static_cast<size_t>(state.range(0)) * MB;
+        for (auto _ : state) {
+            auto* pool = pool::create(capacity, type, options);
+            for (size_t used = 0; used < bytes; used += chunkSize) {
+                auto* chunk = pool->new_buffer(chunkSize);
+                std::memset(chunk, 1, chunkSize);
+            }
+            benchmark::ClobberMemory();
+            delete pool;
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    }
+}
+
+static void BM_Commit_Protect(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Protect, 0));
+}
+
+static void BM_Commit_Fault(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Fault, 0));
+}
+
+static void BM_Commit_FaultPrefault(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Fault, 4 * MB));
+}
+
+// Many threads committing their own pools at once contend on the process-wide mmap lock.
+static void BM_CommitConcurrent_Protect(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Protect, 0));
+}
+
+static void BM_CommitConcurrent_Fault(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Fault, 0));
+}
+
+static void BM_CommitConcurrent_FaultPrefault(benchmark::State& state) {
+    fillPool(state, pool_type::SingleThreaded, commitOptions(commit_mode::Fault, 4 * MB));
+}
+
+BENCHMARK(BM_Commit_Protect)->Arg(16)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Commit_Fault)->Arg(16)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Commit_FaultPrefault)->Arg(16)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CommitConcurrent_Protect)->Arg(16)->ThreadRange(2, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CommitConcurrent_Fault)->Arg(16)->ThreadRange(2, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CommitConcurrent_FaultPrefault)->Arg(16)->ThreadRange(2, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
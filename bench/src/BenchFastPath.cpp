@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include "memory-pool/basic_pool.h"
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t capacity = 64 * 1024 * 1024;
+    constexpr int batch = 4096;
+
+    struct node {
+        node* next;
+        uint64_t value;
+    };
+}
+
+// Allocates through the virtual pool interface.
+static void BM_FastPath_Virtual(benchmark::State& state) {
+    auto* pool = pool::create(capacity, pool_type::SingleThreaded);
+    for (auto _ : state) {
+        node* head = nullptr;
+        for (int i = 0; i < batch; ++i) {
+            head = pool->new_object<node>(head, i);
+        }
+        benchmark::DoNotOptimize(head);
+        pool->reset();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    delete pool;
+}
+
+// Allocates through basic_pool, whose fast path is inlined.
+template<typename ThreadingPolicy, typename CommitPolicy>
+static void BM_FastPath_Basic(benchmark::State& state) {
+    basic_pool<ThreadingPolicy, CommitPolicy> pool(capacity);
+    for (auto _ : state) {
+        node* head = nullptr;
+        for (int i = 0; i < batch; ++i) {
+            head = pool.template new_object<node>(head, i);
+        }
+        benchmark::DoNotOptimize(head);
+        pool.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+BENCHMARK(BM_FastPath_Virtual);
+BENCHMARK(BM_FastPath_Basic<single_threaded, commit_ahead>);
+BENCHMARK(BM_FastPath_Basic<single_threaded, commit_on_fault>);
+BENCHMARK(BM_FastPath_Basic<thread_safe, commit_ahead>);
+BENCHMARK(BM_FastPath_Basic<thread_safe, commit_on_fault>);
@@ -0,0 +1,412 @@
+#pragma once
+#include "memory-pool/memory_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace memory_pool {
+    // Threading policy for a basic_pool that only one thread allocates from at a time.
+    struct single_threaded {
+        // A value only one thread changes, so reads and writes are plain.
+        template<typename T>
+        class cell {
+            T value;
+
+        public:
+            explicit cell(T value)
+                : value(value) {
+            }
+
+            [[nodiscard]] T load(std::memory_order = std::memory_order_relaxed) const {
+                return value;
+            }
+
+            void store(T desired, std::memory_order = std::memory_order_relaxed) {
+                value = desired;
+            }
+
+            void add(T amount) {
+                value += amount;
+            }
+
+            void subtract(T amount) {
+                value -= amount;
+            }
+
+            // Always succeeds, since no other thread can have changed the value.
+            bool compare_exchange(T&, T desired) {
+                value = desired;
+                return true;
+            }
+        };
+
+        // Nothing else commits, so there's nothing to guard.
+        struct commit_mutex {
+            void lock() {
+            }
+
+            void unlock() {
+            }
+        };
+    };
+
+    // Threading policy for a basic_pool that many threads allocate from at once, without a lock.
+    struct thread_safe {
+        template<typename T>
+        class cell {
+            std::atomic<T> value;
+
+        public:
+            explicit cell(T value)
+                : value(value) {
+            }
+
+            [[nodiscard]] T load(const std::memory_order order = std::memory_order_relaxed) const {
+                return value.load(order);
+            }
+
+            void store(T desired, const std::memory_order order = std::memory_order_relaxed) {
+                value.store(desired, order);
+            }
+
+            void add(T amount) {
+                value.fetch_add(amount, std::memory_order_relaxed);
+            }
+
+            void subtract(T amount) {
+                value.fetch_sub(amount, std::memory_order_relaxed);
+            }
+
+            // On failure, loads the current value into expected. On success, synchronizes with the last thread
+            // to change the value, so space one thread gives back is safe for the next to allocate.
+            bool compare_exchange(T& expected, T desired) {
+                return value.compare_exchange_weak(expected, desired, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed);
+            }
+        };
+
+        using commit_mutex = std::mutex;
+    };
+
+    // Commit policy for a basic_pool that commits its reservation a chunk at a time as allocations reach it,
+    // like commit_mode::Protect.
+    struct commit_ahead {
+        static constexpr commit_mode commitMode = commit_mode::Protect;
+        static constexpr size_t chunkBytes = 1 << 20;
+    };
+
+    // Commit policy for a basic_pool whose whole reservation is usable up front, with pages committed when first
+    // written, like commit_mode::Fault. Allocating never checks what's committed.
+    struct commit_on_fault {
+        static constexpr commit_mode commitMode = commit_mode::Fault;
+        static constexpr size_t chunkBytes = 0;
+    };
+
+    // A bump-pointer pool whose threading and commit behavior are chosen at compile time. Calls made on a
+    // basic_pool itself are not virtual and can be inlined, with a constant alignment folded into a mask.
+    // It is also a pool, so it can be passed to code that takes one, where calls go through the virtual interface.
+    // The pool types behind pool::create are basic_pools too, with a commit policy chosen from their options and
+    // features like background commit, NUMA placement and trimming added on top.
+    //
+    // A commit policy has a commitMode and chunkBytes, the number of bytes to commit at a time, or 0 if the whole
+    // reservation is usable up front. A policy with no state, whose members are constants, is settled at compile
+    // time. A policy with state may also have get_commit_margin(), how far ahead of allocations to start
+    // committing, and request_commit(), which asks something else to commit and returns whether it will.
+    template<typename ThreadingPolicy = single_threaded, typename CommitPolicy = commit_ahead>
+    class basic_pool : public pool {
+    protected:
+        template<typename T>
+        using cell = typename ThreadingPolicy::template cell<T>;
+
+        // Whether allocations can reach memory that isn't committed yet.
+        static constexpr bool commitsOnDemand = [] {
+            if constexpr (std::is_empty_v<CommitPolicy>) {
+                return CommitPolicy::chunkBytes != 0;
+            } else {
+                return true;
+            }
+        }();
+
+        const size_t capacity;
+        const size_t reservedBytes; // capacity rounded up to whole pages.
+        char* const buffer; // Page-aligned, unless it's a caller's buffer.
+        cell<size_t> bytesInUse{0};
+        cell<size_t> alignmentFragmentationBytes{0};
+        cell<char*> firstUncommittedByte;
+        cell<size_t> peakBytesBeforeRewind{0};
+        typename ThreadingPolicy::commit_mutex commitMutex;
+        [[no_unique_address]] CommitPolicy commitPolicy;
+
+    private:
+        const bool ownsBuffer; // Whether the reservation is freed with the pool, rather than by a derived pool.
+        // Where the most recent allocation that needed padding starts and how much padding it took, packed as
+        // start << paddingBits | padding, or 0 once freeing it has given the padding back.
+        cell<uint64_t> lastPadding{0};
+        static constexpr unsigned paddingBits = 16;
+
+    public:
+        explicit basic_pool(const size_t capacity)
+            : capacity(capacity),
+              reservedBytes((capacity + get_page_size() - 1) / get_page_size() * get_page_size()),
+              buffer(reserve_buffer(reservedBytes, huge_pages::None, CommitPolicy::commitMode)),
+              firstUncommittedByte(commitsOnDemand ? buffer : buffer + reservedBytes),
+              ownsBuffer(true) {
+        }
+
+        // Allocates from a caller's buffer, such as one on the stack, which must outlive the pool. Only a commit
+        // policy that never commits can use it.
+        basic_pool(void* memory, const size_t size) requires (!commitsOnDemand)
+            : capacity(size),
+              reservedBytes(size),
+              buffer(static_cast<char*>(memory)),
+              firstUncommittedByte(buffer + size),
+              ownsBuffer(false) {
+        }
+
+        basic_pool(const basic_pool&) = delete;
+
+        ~basic_pool() override {
+            run_destructors();
+            if (ownsBuffer) {
+                free_buffer(buffer, reservedBytes);
+            }
+        }
+
+        // Allocates with an alignment known at compile time, which must be a power of 2.
+        template<size_t Alignment = alignof(std::max_align_t)>
+        [[nodiscard]] void* allocate(const size_t size) {
+            static_assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of 2");
+            auto* ret = try_allocate_masked(size, Alignment - 1);
+            if (ret == nullptr) [[unlikely]] {
+                throw_out_of_memory(size, Alignment, capacity - get_size());
+            }
+            return ret;
+        }
+
+        // Allocates with an alignment known only at run time.
+        [[nodiscard]] void* allocate(const size_t size, const size_t alignment) {
+            auto* ret = try_allocate(size, alignment);
+            if (ret == nullptr) [[unlikely]] {
+                throw_out_of_memory(size, alignment, capacity - get_size());
+            }
+            return ret;
+        }
+
+        // Like allocate, but returns nullptr instead of throwing when the pool cannot fit the request.
+        // An alignment that isn't a power of 2 takes a division instead of a mask.
+        [[nodiscard]] void* try_allocate(const size_t size, const size_t alignment) {
+            if ((alignment & (alignment - 1)) == 0) [[likely]] {
+                return try_allocate_masked(size, alignment - 1);
+            }
+            return try_allocate_aligned(size, [alignment](const uintptr_t address) {
+                return (address + alignment - 1) / alignment * alignment;
+            });
+        }
+
+        // Allocates and constructs a new object.
+        template<typename T, typename... Args>
+        [[nodiscard]] T* new_object(Args&&... args) {
+            return new(allocate<alignof(T)>(sizeof(T))) T(std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]] size_t get_capacity() const override {
+            return capacity;
+        }
+
+        [[nodiscard]] size_t get_size() const override {
+            return bytesInUse.load();
+        }
+
+        [[nodiscard]] size_t get_alignment_fragmentation() const override {
+            return alignmentFragmentationBytes.load();
+        }
+
+        [[nodiscard]] size_t get_committed_size() const override {
+            return firstUncommittedByte.load(std::memory_order_acquire) - buffer;
+        }
+
+        [[nodiscard]] size_t get_resident_size() const override {
+            return get_resident_bytes(buffer, get_committed_size());
+        }
+
+        [[nodiscard]] int get_numa_node() const override {
+            return -1;
+        }
+
+        [[nodiscard]] size_t get_peak_size() const override {
+            return std::max(peakBytesBeforeRewind.load(), bytesInUse.load());
+        }
+
+        // Gives nothing back: a basic_pool keeps everything it has committed.
+        size_t trim() override {
+            return 0;
+        }
+
+        // Must not be called while other threads use the pool.
+        void reset() override {
+            rewind(pool_marker{});
+        }
+
+        [[nodiscard]] pool_marker mark() const override {
+            return {bytesInUse.load(), alignmentFragmentationBytes.load(), get_last_destructor()};
+        }
+
+        // Must not be called while other threads use the pool.
+        void rewind(const pool_marker& marker) override {
+            if (marker.position > bytesInUse.load()) {
+                throw std::invalid_argument("Marker is past the pool's current position");
+            }
+            run_destructors(marker.lastDestructor);
+            peakBytesBeforeRewind.store(get_peak_size());
+            bytesInUse.store(marker.position);
+            alignmentFragmentationBytes.store(marker.alignmentFragmentation);
+            lastPadding.store(0);
+        }
+
+    protected:
+        // Takes over a reservation that a derived pool made and frees. Its first committedBytes are usable.
+        basic_pool(const size_t capacity, const size_t reservedBytes, char* buffer, const size_t committedBytes,
+                   CommitPolicy commitPolicy)
+            : capacity(capacity),
+              reservedBytes(reservedBytes),
+              buffer(buffer),
+              firstUncommittedByte(buffer + committedBytes),
+              commitPolicy(std::move(commitPolicy)),
+              ownsBuffer(false) {
+        }
+
+        void* do_allocate(std::size_t size, std::size_t alignment) override {
+            return allocate(size, alignment);
+        }
+
+        bool do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) override {
+            const auto start = reinterpret_cast<uintptr_t>(p);
+            const auto base = reinterpret_cast<uintptr_t>(buffer);
+            if (start < base || start - base > capacity || capacity - (start - base) < oldSize) {
+                return false;
+            }
+            // Only the allocation that ends at the pool's position can move it.
+            const auto offset = start - base + oldSize;
+            if (newSize > oldSize && capacity - offset < newSize - oldSize) {
+                return false;
+            }
+            auto newOffset = offset - oldSize + newSize;
+            auto current = bytesInUse.load();
+            if (current != offset) {
+                return false;
+            }
+            // Freeing the most recent allocation that needed padding gives the padding back too.
+            const auto padding = newSize == 0 ? take_padding(start - base) : 0;
+            newOffset -= padding;
+            do {
+                if (current != offset) {
+                    return false;
+                }
+            } while (!bytesInUse.compare_exchange(current, newOffset));
+            if (padding != 0) {
+                alignmentFragmentationBytes.subtract(padding);
+            }
+            if (newSize < oldSize) {
+                // Save the peak that shrinking lowered, unless another thread saved a higher one.
+                auto peak = peakBytesBeforeRewind.load();
+                while (peak < offset && !peakBytesBeforeRewind.compare_exchange(peak, offset)) {
+                }
+            } else if constexpr (commitsOnDemand) {
+                if (buffer + newOffset + get_commit_margin() > firstUncommittedByte.load(std::memory_order_acquire)) {
+                    commit_through(buffer + newOffset, newSize - oldSize);
+                }
+            }
+            return true;
+        }
+
+    private:
+        // Inlined with a constant mask, the alignment takes one add and one and.
+        [[nodiscard]] void* try_allocate_masked(const size_t size, const size_t mask) {
+            return try_allocate_aligned(size, [mask](const uintptr_t address) {
+                return (address + mask) & ~mask;
+            });
+        }
+
+        // Takes size bytes starting at the first address alignUp gives at or past the pool's position.
+        template<typename AlignUp>
+        [[nodiscard]] void* try_allocate_aligned(const size_t size, const AlignUp& alignUp) {
+            const auto base = reinterpret_cast<uintptr_t>(buffer);
+            auto offset = bytesInUse.load();
+            size_t start;
+            size_t end;
+            do {
+                start = alignUp(base + offset) - base;
+                if (start > capacity || capacity - start < size) [[unlikely]] {
+                    return nullptr;
+                }
+                end = start + size;
+            } while (!bytesInUse.compare_exchange(offset, end));
+
+            if (start != offset) {
+                alignmentFragmentationBytes.add(start - offset);
+                remember_padding(start, start - offset);
+            }
+            if constexpr (commitsOnDemand) {
+                auto* uncommitted = firstUncommittedByte.load(std::memory_order_acquire);
+                if (buffer + end + get_commit_margin() > uncommitted) [[unlikely]] {
+                    commit_through(buffer + end, size);
+                }
+            }
+            return buffer + start;
+        }
+
+        // Remembers the padding before the allocation at start, so freeing it can give the padding back.
+        void remember_padding(const size_t start, const size_t padding) {
+            const bool fits = padding < (size_t{1} << paddingBits) && start < (uint64_t{1} << (64 - paddingBits));
+            lastPadding.store(fits ? uint64_t{start} << paddingBits | padding : 0);
+        }
+
+        // Returns the padding before the allocation at start and forgets it, if it's the one remembered.
+        [[nodiscard]] size_t take_padding(const size_t start) {
+            auto packed = lastPadding.load();
+            do {
+                if (packed == 0 || packed >> paddingBits != start) {
+                    return 0;
+                }
+            } while (!lastPadding.compare_exchange(packed, 0));
+            return packed & ((uint64_t{1} << paddingBits) - 1);
+        }
+
+        [[nodiscard]] size_t get_commit_margin() const {
+            if constexpr (requires { commitPolicy.get_commit_margin(); }) {
+                return commitPolicy.get_commit_margin();
+            } else {
+                return 0;
+            }
+        }
+
+        // Commits enough of the reservation that every byte before end is usable, and size bytes more, so the
+        // allocations after this one don't all land here too.
+        void commit_through(char* end, const size_t size) {
+            if (firstUncommittedByte.load(std::memory_order_acquire) == buffer + reservedBytes) {
+                // Everything is committed, so there's nothing to do or to ask for.
+                return;
+            }
+            if constexpr (requires { commitPolicy.request_commit(); }) {
+                if (commitPolicy.request_commit() && end <= firstUncommittedByte.load(std::memory_order_acquire)) {
+                    // What was asked to commit will catch up before we need more.
+                    return;
+                }
+            }
+            std::lock_guard lock(commitMutex);
+            // Another thread may have committed past end while we waited.
+            auto* uncommitted = firstUncommittedByte.load(std::memory_order_relaxed);
+            if (end <= uncommitted) {
+                return;
+            }
+            const size_t chunkBytes = commitPolicy.chunkBytes;
+            const size_t wanted = (end - uncommitted + size + chunkBytes - 1) / chunkBytes * chunkBytes;
+            const auto toCommit = std::min(wanted, static_cast<size_t>((buffer + reservedBytes) - uncommitted));
+            commit_pages(uncommitted, toCommit, commitPolicy.commitMode);
+            firstUncommittedByte.store(uncommitted + toCommit, std::memory_order_release);
+        }
+    };
+}
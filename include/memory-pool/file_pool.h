@@ -0,0 +1,97 @@
+#pragma once
+#include "memory-pool/memory_pool.h"
+#include <filesystem>
+#include <string>
+
+namespace memory_pool {
+    // Where a file_pool is mapped when it's opened.
+    enum class file_mapping {
+        // Maps the pool wherever there's room, which may differ each time it's opened. Data in the pool must refer
+        // to other data in it by offset. See file_pool::to_offset and file_pool::from_offset.
+        Relocatable,
+
+        // Maps the pool at the address it was created at, so pointers into it stay valid every time it's opened.
+        // Opening fails if something else is already mapped there.
+        Fixed
+    };
+
+    struct file_pool_options {
+        file_mapping mapping = file_mapping::Relocatable;
+
+        // For a new pool mapped at a fixed address, the address to create it at, which must be page-aligned.
+        // If null, the system chooses.
+        void* baseAddress = nullptr;
+    };
+
+    // A pool whose memory is a file, so that what's allocated in it outlives the process. The pool's allocation
+    // position and root pointer are kept in the file along with its data, so a later process that opens the file
+    // gets everything back as it was left, without deserializing.
+    // The file can also be a shared memory object, which several processes map at once to hand each other data
+    // without copying it. See open_shared.
+    // Allocating is safe on multiple threads, and on multiple processes that share the pool, like a ThreadSafe pool.
+    // The whole file is usable up front, and its pages are read or written when first touched.
+    class file_pool : public pool {
+    public:
+        // Opens the pool in a file, or creates the file with room for capacity bytes if it doesn't exist.
+        // An existing file keeps the capacity it was created with.
+        [[nodiscard]] static file_pool* open(const std::filesystem::path& path, size_t capacity,
+                                             const file_pool_options& options = {});
+
+        // Opens the pool in a shared memory object, or creates it with room for capacity bytes if it doesn't exist.
+        // Every process that opens the same name shares the pool. The object lasts until remove_shared is called,
+        // or until the system restarts. With an empty name, creates a pool in anonymous shared memory, which only
+        // processes forked from this one after it's created share.
+        [[nodiscard]] static file_pool* open_shared(const std::string& name, size_t capacity,
+                                                    const file_pool_options& options = {});
+
+        // Removes a shared memory object's name. Processes that have its pool open can keep using it.
+        static void remove_shared(const std::string& name);
+
+        // Whether opening created the pool, rather than finding one in the file.
+        [[nodiscard]] virtual bool is_new() const = 0;
+
+        // Gets the object the pool's data is reached from, or nullptr if none has been set.
+        [[nodiscard]] virtual void* get_root() const = 0;
+
+        virtual void set_root(void* root) = 0;
+
+        // Converts between pointers into the pool and offsets, which stay the same wherever the pool is mapped.
+        [[nodiscard]] virtual size_t to_offset(const void* pointer) const = 0;
+
+        [[nodiscard]] virtual void* from_offset(size_t offset) const = 0;
+
+        // Writes the pool's data and state to the file, and waits until they're on disk. Without this, they still
+        // reach the file when the system gets around to it, even if the process exits without destroying the pool.
+        virtual void sync() = 0;
+
+    protected:
+        struct mapped_file {
+            char* buffer = nullptr; // Null until the file is mapped.
+            size_t size = 0;
+            bool created = false;
+            intptr_t handle = -1; // The open file or shared memory object.
+            intptr_t mapping = 0; // On Windows, the file mapping object that views are made from.
+        };
+
+        file_pool() = default;
+
+        // Opens a file, creating it with the given size if it doesn't exist. If another process is creating it, waits
+        // briefly until it has its size, and takes over a file that stays empty.
+        [[nodiscard]] static mapped_file open_file(const std::filesystem::path& path, size_t size);
+
+        // Opens a shared memory object, creating it with the given size if it doesn't exist. If another process is
+        // creating it, waits until it has its size.
+        [[nodiscard]] static mapped_file open_shared_memory(const std::string& name, size_t size);
+
+        // Maps the whole of an open file readable and writable. If address isn't null, maps it there or throws.
+        static void map_file(mapped_file& file, void* address);
+
+        static void unmap_file(mapped_file& file);
+
+        // Unmaps the file if it's mapped, and closes it.
+        static void close_file(mapped_file& file);
+
+        // Writes the first size bytes of a mapped file to disk.
+        static void sync_file(const mapped_file& file, size_t size);
+    };
+}
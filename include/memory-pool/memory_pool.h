@@ -1,9 +1,17 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <memory_resource>
 #include <utility>
 #include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace memory_pool {
     enum class pool_type {
@@ -11,10 +19,253 @@ namespace memory_pool {
         SingleThreaded,
 
         // Makes it safe to allocate from the pool on multiple threads.
+        // Allocation does not take a lock; only committing more of the reservation is serialized.
         ThreadSafe,
 
         // Makes the pool act as if it's a separate pool for each thread in the program.
-        PerThread
+        PerThread,
+
+        // Makes it safe to allocate from the pool on multiple threads by serializing every allocation with a mutex.
+        Locked,
+
+        // Makes it safe to allocate from the pool on multiple threads. Each thread takes a buffer from the pool's
+        // capacity and allocates from it without synchronization, going back to the pool only when it runs out.
+        // Unlike PerThread, all threads share one capacity.
+        ThreadBuffered,
+
+        // Makes it safe to allocate from the pool on multiple threads. The capacity is split into a fixed number of
+        // shards, and each thread allocates from the shard belonging to the CPU it is running on. One allocation
+        // must fit in a single shard, so it can't be larger than the capacity divided by the shard count.
+        PerCpu,
+
+        // Makes it safe to allocate from the pool on multiple threads, and reuses memory that is deallocated.
+        // Requests are rounded up to a power-of-2 size class, and freed blocks wait on a free list for their class,
+        // cached per thread. Requests over 1 MiB, or aligned to more than 4 KiB, are never reused.
+        Recycling
+    };
+
+    // How a pool gives unused memory back to the operating system. See pool::trim.
+    enum class decommit_policy {
+        // Lets the kernel reclaim the pages lazily, when it needs memory (MADV_FREE). This is the cheapest option,
+        // but resident memory drops only under memory pressure.
+        Free,
+
+        // Releases the pages immediately (MADV_DONTNEED). Touching them again faults in zeroed pages.
+        DontNeed
+    };
+
+    // Whether a pool's memory is backed by huge pages, which cost fewer TLB misses and page faults than base pages.
+    enum class huge_pages {
+        // Uses the system's base page size.
+        None,
+
+        // Aligns reservations to huge pages and asks the kernel to back them with transparent huge pages
+        // (MADV_HUGEPAGE).
+        Transparent,
+
+        // Backs reservations with huge pages set aside by the administrator (MAP_HUGETLB). Falls back to
+        // Transparent when not enough are available.
+        Explicit
+    };
+
+    // How a pool makes its reserved memory usable.
+    enum class commit_mode {
+        // Commits memory ahead of the allocations that need it, with a system call for each step (mprotect).
+        Protect,
+
+        // Makes the whole reservation readable and writable up front, without reserving swap for it
+        // (MAP_NORESERVE). Pages are committed when first written, so allocating makes no system calls.
+        Fault
+    };
+
+    // Where a pool's physical memory is placed on a machine with more than one NUMA node.
+    enum class numa_policy {
+        // Leaves placement to the operating system.
+        Default,
+
+        // Prefers the node of the thread that reserves the memory (MPOL_PREFERRED). A PerThread pool reserves memory
+        // on each thread that uses it, and each PerCpu shard prefers the node of its CPU.
+        Local,
+
+        // Spreads pages evenly across all nodes (MPOL_INTERLEAVE), for pools shared by threads on every node.
+        Interleave
+    };
+
+    // Settings for creating a pool. The defaults suit most uses.
+    struct pool_options {
+        // For pool_type::ThreadBuffered, the number of bytes each thread takes from the pool at a time.
+        size_t threadBufferSize = 64 * 1024;
+
+        // For pool_type::PerCpu, the number of shards to split the capacity into. 0 means one per CPU.
+        // Each shard gets an equal part of the capacity, which limits the size of a single allocation.
+        size_t cpuShardCount = 0;
+
+        // How trim gives unused memory back to the operating system.
+        decommit_policy decommitPolicy = decommit_policy::DontNeed;
+
+        // The number of bytes past the first unused byte that trim leaves alone, so the next allocations
+        // reuse warm pages.
+        size_t warmReserveBytes = 0;
+
+        // Whether reset and rewind trim the pool.
+        bool trimOnRewind = false;
+
+        // Whether to back the pool with huge pages. Commits and trims then happen in whole huge pages.
+        huge_pages hugePages = huge_pages::None;
+
+        commit_mode commitMode = commit_mode::Protect;
+
+        // For commit_mode::Fault, the number of bytes to prefault at a time ahead of allocations
+        // (MADV_POPULATE_WRITE). 0 leaves every page to fault in when first written.
+        size_t prefaultBytes = 0;
+
+        // If not 0, a background thread keeps up to this many bytes past the first unused byte committed and
+        // prefaulted, so allocating threads rarely enter the kernel. It never commits further ahead than this.
+        size_t backgroundCommitBytes = 0;
+
+        // Whether the pool reserves another segment when it runs out, instead of throwing. Each segment is twice the
+        // size of the one before. Supported by SingleThreaded, ThreadSafe and PerThread pools.
+        bool growable = false;
+
+        // For a growable pool, the most bytes all its segments may add up to. 0 means no limit.
+        size_t maxCapacity = 0;
+
+        numa_policy numaPolicy = numa_policy::Default;
+
+        // Whether new_object records how to destroy objects that aren't trivially destructible, so that the pool
+        // destroys them, most recent first, when it is reset, rewound past them, or destroyed.
+        bool runDestructors = false;
+    };
+
+    // Limits for the process-wide cache of reservations that destroyed pools leave for new ones.
+    // See pool::configure_reservation_cache.
+    struct reservation_cache_options {
+        // The most reservations the cache holds. 0 turns the cache off, which is the default.
+        size_t maxReservations = 0;
+
+        // The most bytes of reservations the cache holds. 0 means no limit.
+        size_t maxBytes = 0;
+
+        // Whether cached reservations keep the physical memory behind their committed pages, so the next pool's
+        // first writes to them don't fault. Otherwise their pages are released (MADV_DONTNEED) but stay committed.
+        bool keepWarm = false;
+    };
+
+    struct reservation_cache_statistics {
+        // Pools that took a reservation from the cache, and pools that found none to take while it was on.
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        // Reservations the cache freed to stay within its limits.
+        uint64_t evictions = 0;
+
+        // What the cache holds now.
+        size_t reservations = 0;
+        size_t bytes = 0;
+    };
+
+    // Stored in a pool just before an object the pool will destroy. See pool_options::runDestructors.
+    struct destructor_entry {
+        destructor_entry* previous;
+        void (*destroy)(destructor_entry* entry);
+    };
+
+    // A position in a pool that the pool can later be rewound to. See pool::mark.
+    struct pool_marker {
+        size_t position;
+        size_t alignmentFragmentation;
+        const destructor_entry* lastDestructor = nullptr;
+    };
+
+    // A block of a pool's memory that hands out allocations itself by bumping a pointer, with no virtual call, pool
+    // capacity check or lock. See pool::new_span. Whatever isn't taken from it stays allocated in the pool.
+    class pool_span {
+        char* cursor;
+        char* end;
+
+    public:
+        pool_span(void* buffer, size_t size)
+            : cursor(static_cast<char*>(buffer)), end(cursor + size) {
+        }
+
+        // Takes a region with the given size and alignment, or returns nullptr if there's no room left for it.
+        [[nodiscard]] void* try_take(size_t size, size_t alignment) {
+            const auto address = reinterpret_cast<uintptr_t>(cursor);
+            uintptr_t aligned;
+            if ((alignment & (alignment - 1)) == 0) {
+                aligned = (address + alignment - 1) & ~(alignment - 1);
+            } else {
+                aligned = (address + alignment - 1) / alignment * alignment;
+            }
+            const auto endAddress = reinterpret_cast<uintptr_t>(end);
+            if (aligned > endAddress || size > endAddress - aligned) {
+                return nullptr;
+            }
+            cursor = reinterpret_cast<char*>(aligned + size);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Constructs a new object in the span, or returns nullptr if there's no room left for it.
+        template<typename T, typename... Args>
+        [[nodiscard]] T* try_new_object(Args&&... args) {
+            auto* buffer = try_take(sizeof(T), alignof(T));
+            if (buffer == nullptr) {
+                return nullptr;
+            }
+            return new(buffer) T(std::forward<Args>(args)...);
+        }
+
+        // Gets the number of bytes not yet taken.
+        [[nodiscard]] size_t get_remaining() const {
+            return end - cursor;
+        }
+    };
+
+    // Sizes describing a pool, or one thread's part of a PerThread pool.
+    struct pool_usage {
+        size_t capacity = 0;
+        size_t size = 0;
+        size_t alignmentFragmentation = 0;
+        size_t committedSize = 0;
+        size_t peakSize = 0;
+    };
+
+    // One thread's part of a PerThread pool.
+    struct thread_usage : pool_usage {
+        std::thread::id threadId;
+    };
+
+    // A snapshot of a pool's statistics. See pool::get_statistics.
+    struct pool_statistics : pool_usage {
+        // For a PerThread pool, one entry for each thread that has a pool. Empty for other types of pools.
+        std::vector<thread_usage> threads;
+    };
+
+    // Counters covering every pool in the process. See pool::get_metrics.
+    struct pool_metrics {
+        static constexpr size_t sizeBuckets = 65;
+        static constexpr size_t alignmentBuckets = 64;
+
+        // Whether the library was built with MEMORY_POOL_METRICS. If not, every counter is 0.
+        bool enabled = false;
+
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t deallocations = 0;
+
+        // Allocations by size. Bucket 0 counts empty requests, and bucket i counts sizes from 2^(i-1) to 2^i - 1.
+        std::array<uint64_t, sizeBuckets> sizeHistogram{};
+
+        // Allocations by alignment. Bucket i counts requests aligned to 2^i.
+        std::array<uint64_t, alignmentBuckets> alignmentHistogram{};
+
+        // System calls that commit or prefault memory, and the time spent in them.
+        uint64_t commits = 0;
+        uint64_t commitNanoseconds = 0;
+
+        // Allocations from a Locked pool that had to wait for its mutex, and the time spent waiting.
+        uint64_t lockWaits = 0;
+        uint64_t lockWaitNanoseconds = 0;
     };
 
     class pool : public std::pmr::memory_resource {
@@ -25,7 +276,19 @@ namespace memory_pool {
 
         [[nodiscard]] static pool* create(size_t capacity, pool_type type);
 
-        // Gets the maximum size in bytes of this pool.
+        // Creates a pool that can hold up to capacity bytes. A PerCpu pool splits the capacity into shards, so an
+        // allocation larger than one shard's capacity throws std::invalid_argument even when the pool has room.
+        [[nodiscard]] static pool* create(size_t capacity, pool_type type, const pool_options& options);
+
+        // Creates a pool that allocates from the given buffer, such as one on the stack, and reserves memory only
+        // once an allocation doesn't fit in it. The buffer counts toward the capacity and must outlive the pool.
+        // Once the buffer is full, try_extend, shrink and deallocate no longer reach allocations made in it.
+        // Supported by SingleThreaded and ThreadSafe pools that aren't growable.
+        [[nodiscard]] static pool* create(size_t capacity, pool_type type, const pool_options& options,
+                                          void* initialBuffer, size_t initialBufferSize);
+
+        // Gets the maximum size in bytes of this pool. For a growable pool, the total size of its segments so far.
+        // For a PerThread pool, this and the other statistics describe the calling thread's pool.
         [[nodiscard]] virtual size_t get_capacity() const = 0;
 
         // Gets the number of bytes currently allocated in this pool.
@@ -34,38 +297,393 @@ namespace memory_pool {
         // Gets the number of bytes wasted due to alignment requests.
         [[nodiscard]] virtual size_t get_alignment_fragmentation() const = 0;
 
+        // Gets the number of bytes of this pool's reservation that can be used without a system call.
+        [[nodiscard]] virtual size_t get_committed_size() const = 0;
+
+        // Gets the number of bytes of this pool's reservation that are backed by physical memory.
+        [[nodiscard]] virtual size_t get_resident_size() const = 0;
+
+        // Gets the NUMA node this pool's memory is bound to, or -1 if it isn't bound to one node.
+        // For a PerThread pool, gets the calling thread's pool's node. For a PerCpu pool, gets the node of the shard
+        // the calling thread allocates from.
+        [[nodiscard]] virtual int get_numa_node() const = 0;
+
+        // Gets the largest size this pool has had since it was created. Pools made of several parts report the sum
+        // of each part's peak. For a Recycling pool, gets the most bytes it has carved into blocks.
+        [[nodiscard]] virtual size_t get_peak_size() const = 0;
+
+        // Gets all of this pool's statistics at once. For a PerThread pool, the totals cover every thread's pool,
+        // and reading them takes no lock, so a monitoring thread doesn't slow down the threads that allocate.
+        [[nodiscard]] virtual pool_statistics get_statistics() const;
+
+        // Sets the limits of the process-wide reservation cache. When it's on, destroyed pools leave their
+        // reservations in it, and new pools reserving the same size with the same huge pages and commit mode take
+        // them instead of reserving and committing memory. Pools with a NUMA policy never use it.
+        static void configure_reservation_cache(const reservation_cache_options& options);
+
+        [[nodiscard]] static reservation_cache_statistics get_reservation_cache_statistics();
+
+        // Gets the counters of every pool in the process. Each thread counts into its own counters, so counting
+        // adds no contention. Counting is compiled out unless the library is built with MEMORY_POOL_METRICS.
+        [[nodiscard]] static pool_metrics get_metrics();
+
+        // Gives the physical memory behind committed but unused pages back to the operating system, keeping the
+        // pool's warm reserve. The pages stay committed. Returns the number of bytes given back.
+        // For a PerThread pool, affects only the calling thread's pool.
+        virtual size_t trim() = 0;
+
+        // Frees every allocation at once. The pool keeps its memory reserved and committed for reuse.
+        // For a PerThread pool, affects only the calling thread's pool.
+        virtual void reset() = 0;
+
+        // Records the current allocation position, so that later allocations can all be freed with rewind.
+        // For a PerThread pool, records the calling thread's position.
+        [[nodiscard]] virtual pool_marker mark() const;
+
+        // Frees every allocation made since the marker was taken. Markers taken after this one become invalid.
+        virtual void rewind(const pool_marker& marker);
+
         // Allocates a region of memory with the given size and alignment.
         [[nodiscard]] void* new_buffer(std::size_t size, std::size_t alignment);
 
         // Allocates a region of memory (unaligned).
         [[nodiscard]] void* new_buffer(std::size_t size);
 
-        // Allocates and constructs a new object.
+        // Allocates and constructs a new object. If the pool runs destructors, an object that isn't trivially
+        // destructible must not be deallocated, since the pool will destroy it.
         template<typename T, typename... Args>
         [[nodiscard]] T* new_object(Args&&... args) {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                if (runsDestructors) {
+                    return new_destroyed_object<T>(std::forward<Args>(args)...);
+                }
+            }
             return new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
         }
 
+        // Allocates count regions of memory with the given size and alignment, storing them in out.
+        // The pool is checked, and locked, once for the whole batch.
+        void new_buffers(std::size_t count, std::size_t size, std::size_t alignment, void** out);
+
+        // Grows the pool's most recent allocation from oldSize to newSize bytes without moving it. Returns false,
+        // changing nothing, if p isn't the most recent allocation or the pool has no room after it. Pools that
+        // can't tell which allocation is the most recent, like ThreadBuffered, PerCpu and Recycling pools, always
+        // return false.
+        [[nodiscard]] bool try_extend(void* p, std::size_t oldSize, std::size_t newSize);
+
+        // Shrinks the pool's most recent allocation from oldSize to newSize bytes, giving the bytes after it back
+        // to the pool. Returns false, changing nothing, if p isn't the most recent allocation.
+        bool shrink(void* p, std::size_t oldSize, std::size_t newSize);
+
+        // Creates a pool for short-lived work, like handling one request, whose memory comes from this pool.
+        // The child takes space from the end of this pool as it allocates, so this pool's size includes what the
+        // child uses. Resetting or destroying the child gives the space back, unless this pool has allocated
+        // something after it. Parents that can't resize allocations, like ThreadBuffered, PerCpu and Recycling pools,
+        // give the child a separate allocation for each of its own, and get none back until they're reset.
+        // The child's size can't pass capacity. Only one thread at a time may use the child, as with a SingleThreaded
+        // pool, but this pool may be shared. The child must be destroyed before this pool.
+        [[nodiscard]] pool* create_child(size_t capacity);
+
+        // Allocates a region that hands out smaller allocations without going back to the pool.
+        [[nodiscard]] pool_span new_span(std::size_t size, std::size_t alignment);
+
+        // Allocates an array of count objects, constructing each from the same arguments.
+        template<typename T, typename... Args>
+        [[nodiscard]] T* new_array(std::size_t count, const Args&... args) {
+            if (count > SIZE_MAX / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            auto* ret = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+            std::size_t constructed = 0;
+            try {
+                for (; constructed < count; ++constructed) {
+                    new(ret + constructed) T(args...);
+                }
+            } catch (...) {
+                while (constructed > 0) {
+                    ret[--constructed].~T();
+                }
+                deallocate(ret, count * sizeof(T), alignof(T));
+                throw;
+            }
+            return ret;
+        }
+
     protected:
         pool() = default;
 
+        // Runs the destructors of objects created since until, most recent first.
+        void run_destructors(const destructor_entry* until = nullptr);
+
+        [[nodiscard]] const destructor_entry* get_last_destructor() const {
+            return lastDestructor.load(std::memory_order_acquire);
+        }
+
+        // Gets the pool whose reset and rewind should destroy objects created by new_object.
+        [[nodiscard]] virtual pool& get_destructor_owner() {
+            return *this;
+        }
+
         [[nodiscard]] void* do_allocate(std::size_t size, std::size_t alignment) override = 0;
 
         [[nodiscard]] void* do_allocate(std::size_t size);
 
+        // Gives the memory back if it's the pool's most recent allocation, so memory freed in the reverse of the
+        // order it was allocated is all reused. SingleThreaded, ThreadSafe, PerThread and Locked pools also give back
+        // the padding that aligned their most recent padded allocation; other padding stays in use until reset or
+        // rewind.
         void do_deallocate(void* p, std::size_t size, std::size_t alignment) override;
 
+        // Allocates a batch for new_buffers. By default, takes the whole batch from the pool as one allocation.
+        virtual void do_allocate_bulk(std::size_t count, std::size_t size, std::size_t alignment, void** out);
+
         [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override;
 
+        // Resizes the allocation at p in place, if it's the most recent one and there's room. By default, never can.
+        [[nodiscard]] virtual bool do_resize(void* p, std::size_t oldSize, std::size_t newSize);
+
+        // Throws the exception for a request the pool cannot fit.
+        [[noreturn]] static void throw_out_of_memory(size_t size, size_t alignment, size_t freeBytes);
+
         [[nodiscard]] static char* reserve_buffer(size_t size);
 
+        // Reserves a buffer aligned to, and backed by, the given kind of pages.
+        // Size must be a multiple of the page size for that kind.
+        [[nodiscard]] static char* reserve_buffer(size_t size, huge_pages hugePages, commit_mode commitMode);
+
         static void allocate_reservation(char* buffer, size_t size);
 
+        // Faults in pages of a readable and writable buffer so that first writes to them don't.
+        static void prefault_pages(char* buffer, size_t size);
+
+        // Makes part of a reservation usable the way the commit mode says: by committing it, or by prefaulting it.
+        static void commit_pages(char* buffer, size_t size, commit_mode commitMode);
+
         static void free_buffer(char* buffer, size_t size);
 
+        // Reserves a buffer like reserve_buffer, but takes one from the reservation cache if it has a match.
+        // Sets committedBytes to how much of it is already committed: 0 for a new reservation.
+        [[nodiscard]] static char* take_reservation(size_t size, huge_pages hugePages, commit_mode commitMode,
+                                                    numa_policy numaPolicy, size_t& committedBytes);
+
+        // Frees a buffer from take_reservation, or leaves it in the reservation cache if there's room.
+        static void give_back_reservation(char* buffer, size_t size, huge_pages hugePages, commit_mode commitMode,
+                                          numa_policy numaPolicy, size_t committedBytes);
+
+        // Releases the committed pages from the warm reserve past firstUnusedByte up to firstUncommittedByte.
+        // Returns the number of bytes released.
+        static size_t release_unused_pages(char* firstUnusedByte, char* firstUncommittedByte, size_t warmReserveBytes,
+                                           decommit_policy policy, size_t pageSize);
+
+        // Gives the physical memory behind committed pages back to the operating system.
+        static void release_pages(char* buffer, size_t size, decommit_policy policy);
+
+        // Counts the bytes in the given page-aligned range that are backed by physical memory.
+        [[nodiscard]] static size_t get_resident_bytes(char* buffer, size_t size);
+
         [[nodiscard]] static size_t get_page_size();
 
+        [[nodiscard]] static size_t get_huge_page_size();
+
+        // Gets the page size used by reservations with the given kind of pages.
+        [[nodiscard]] static size_t get_page_size(huge_pages hugePages);
+
         [[nodiscard]] static char* get_containing_page(char* pointer);
+
+        [[nodiscard]] static char* get_containing_page(char* pointer, size_t pageSize);
+
+        // Gets the index of the CPU the calling thread is running on. The thread may be migrated at any time.
+        [[nodiscard]] static size_t get_current_cpu();
+
+        [[nodiscard]] static size_t get_cpu_count();
+
+        // Gets the NUMA node a CPU belongs to, or -1 if it isn't known.
+        [[nodiscard]] static int get_cpu_numa_node(size_t cpu);
+
+        // Applies a NUMA policy to a reservation before any of it is touched. For numa_policy::Local, node is the
+        // node to prefer, or -1 for the calling thread's. Returns the node the memory is bound to, or -1 if none.
+        static int set_numa_policy(char* buffer, size_t size, numa_policy policy, int node);
+
+    private:
+        std::atomic<destructor_entry*> lastDestructor = nullptr;
+        bool runsDestructors = false;
+
+        // Constructs an object after an entry that records how to destroy it.
+        template<typename T, typename... Args>
+        [[nodiscard]] T* new_destroyed_object(Args&&... args) {
+            constexpr auto offset = (sizeof(destructor_entry) + alignof(T) - 1) / alignof(T) * alignof(T);
+            auto* buffer = static_cast<char*>(allocate(offset + sizeof(T),
+                                                       std::max(alignof(T), alignof(destructor_entry))));
+            auto* ret = new(buffer + offset) T(std::forward<Args>(args)...);
+            auto* entry = new(buffer) destructor_entry{nullptr, [](destructor_entry* entry) {
+                std::launder(reinterpret_cast<T*>(reinterpret_cast<char*>(entry) + offset))->~T();
+            }};
+            auto& owner = get_destructor_owner();
+            entry->previous = owner.lastDestructor.load(std::memory_order_relaxed);
+            while (!owner.lastDestructor.compare_exchange_weak(entry->previous, entry, std::memory_order_release,
+                                                               std::memory_order_relaxed)) {
+            }
+            return ret;
+        }
+    };
+
+    // An array of trivially copyable values in a pool that grows in place while it's the pool's most recent
+    // allocation, so appending to it doesn't copy. Otherwise it moves to a new allocation twice as big.
+    template<typename T>
+    class pool_buffer {
+        static_assert(std::is_trivially_copyable_v<T>, "pool_buffer moves its values by copying their bytes");
+
+        pool* owner;
+        T* values = nullptr;
+        size_t count = 0;
+        size_t capacity = 0;
+
+    public:
+        explicit pool_buffer(pool& owner, const size_t initialCapacity = 0)
+            : owner(&owner) {
+            reserve(initialCapacity);
+        }
+
+        pool_buffer(const pool_buffer&) = delete;
+
+        pool_buffer(pool_buffer&& other) noexcept
+            : owner(other.owner), values(std::exchange(other.values, nullptr)), count(std::exchange(other.count, 0)),
+              capacity(std::exchange(other.capacity, 0)) {
+        }
+
+        ~pool_buffer() {
+            if (values != nullptr) {
+                owner->deallocate(values, capacity * sizeof(T), alignof(T));
+            }
+        }
+
+        void push_back(const T& value) {
+            if (count == capacity) {
+                grow(count + 1);
+            }
+            values[count++] = value;
+        }
+
+        void append(const T* source, const size_t sourceCount) {
+            if (capacity - count < sourceCount) {
+                grow(count + sourceCount);
+            }
+            std::copy_n(source, sourceCount, values + count);
+            count += sourceCount;
+        }
+
+        // New values are left uninitialized.
+        void resize(const size_t newCount) {
+            if (newCount > capacity) {
+                grow(newCount);
+            }
+            count = newCount;
+        }
+
+        void reserve(const size_t newCapacity) {
+            if (newCapacity > capacity) {
+                move_to(newCapacity);
+            }
+        }
+
+        // Gives the unused capacity back to the pool, if the buffer is still its most recent allocation.
+        void shrink_to_fit() {
+            if (count < capacity && values != nullptr &&
+                owner->shrink(values, capacity * sizeof(T), count * sizeof(T))) {
+                capacity = count;
+            }
+        }
+
+        void clear() {
+            count = 0;
+        }
+
+        [[nodiscard]] T* data() {
+            return values;
+        }
+
+        [[nodiscard]] const T* data() const {
+            return values;
+        }
+
+        [[nodiscard]] size_t size() const {
+            return count;
+        }
+
+        [[nodiscard]] size_t get_capacity() const {
+            return capacity;
+        }
+
+        [[nodiscard]] T& operator[](const size_t index) {
+            return values[index];
+        }
+
+        [[nodiscard]] const T& operator[](const size_t index) const {
+            return values[index];
+        }
+
+        [[nodiscard]] T* begin() {
+            return values;
+        }
+
+        [[nodiscard]] T* end() {
+            return values + count;
+        }
+
+        [[nodiscard]] const T* begin() const {
+            return values;
+        }
+
+        [[nodiscard]] const T* end() const {
+            return values + count;
+        }
+
+        [[nodiscard]] pool* get_pool() const {
+            return owner;
+        }
+
+    private:
+        // Makes room for at least needed values, doubling the capacity if it can.
+        void grow(const size_t needed) {
+            move_to(std::max({needed, capacity * 2, static_cast<size_t>(16 / sizeof(T) + 1)}));
+        }
+
+        void move_to(const size_t newCapacity) {
+            if (newCapacity > SIZE_MAX / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            if (values != nullptr && owner->try_extend(values, capacity * sizeof(T), newCapacity * sizeof(T))) {
+                capacity = newCapacity;
+                return;
+            }
+            auto* moved = static_cast<T*>(owner->allocate(newCapacity * sizeof(T), alignof(T)));
+            if (values != nullptr) {
+                std::copy_n(values, count, moved);
+                owner->deallocate(values, capacity * sizeof(T), alignof(T));
+            }
+            values = moved;
+            capacity = newCapacity;
+        }
+    };
+
+    // Rewinds a pool to where it was when the scope was entered, unless the pool is already back before that.
+    class pool_scope {
+        pool& owner;
+        const pool_marker marker;
+
+    public:
+        explicit pool_scope(pool& pool)
+            : owner(pool), marker(pool.mark()) {
+        }
+
+        pool_scope(const pool_scope&) = delete;
+
+        ~pool_scope() {
+            // A reset inside the scope may already have moved the pool back past the marker.
+            if (marker.position <= owner.mark().position) {
+                owner.rewind(marker);
+            }
+        }
     };
 
     template<class T>
@@ -94,8 +712,9 @@ namespace memory_pool {
             return static_cast<value_type*>(impl->allocate(count * sizeof(value_type), alignof(value_type)));
         }
 
-        void deallocate(value_type*, size_t) noexcept {
-            // Do nothing.
+        // Gives the memory back to the pool only if it's the pool's most recent allocation.
+        void deallocate(value_type* p, size_t count) noexcept {
+            impl->deallocate(p, count * sizeof(value_type), alignof(value_type));
         }
 
         template<typename... Args>
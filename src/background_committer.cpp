@@ -0,0 +1,86 @@
+#include "internal.h"
+#include <algorithm>
+
+background_committer& background_committer::instance() {
+    static background_committer committer;
+    return committer;
+}
+
+background_committer::~background_committer() {
+    std::unique_lock lock(mutex);
+    if (!worker.joinable()) {
+        return;
+    }
+    // Pools that were never destroyed are still registered.
+    stopping = true;
+    lock.unlock();
+    wake.notify_all();
+    worker.join();
+}
+
+void background_committer::add(background_commit_target* target) {
+    std::unique_lock lock(mutex);
+    idle.wait(lock, [this] { return !stopping; });
+    targets.push_back(target);
+    if (!worker.joinable()) {
+        worker = std::thread([this] { run(); });
+    }
+}
+
+void background_committer::remove(background_commit_target* target) {
+    std::unique_lock lock(mutex);
+    idle.wait(lock, [this, target] { return current != target; });
+    targets.erase(std::find(targets.begin(), targets.end(), target));
+    if (!targets.empty() || stopping) {
+        return;
+    }
+
+    // That was the last pool, so stop the worker.
+    stopping = true;
+    auto finished = std::move(worker);
+    lock.unlock();
+    wake.notify_all();
+    finished.join();
+    lock.lock();
+    stopping = false;
+    idle.notify_all();
+}
+
+void background_committer::request(background_commit_target* target) {
+    if (target->commitRequested.exchange(true, std::memory_order_relaxed)) {
+        return; // Already asked.
+    }
+    {
+        std::lock_guard lock(mutex);
+        requested = true;
+    }
+    wake.notify_one();
+}
+
+void background_committer::run() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return requested || stopping; });
+        if (stopping) {
+            return;
+        }
+        requested = false;
+        // Targets may come and go while we commit without the lock, so index rather than iterate.
+        for (size_t i = 0; i < targets.size(); ++i) {
+            auto* target = targets[i];
+            if (!target->commitRequested.exchange(false, std::memory_order_relaxed)) {
+                continue;
+            }
+            current = target;
+            lock.unlock();
+            try {
+                target->commit_in_background();
+            } catch (...) {
+                // The allocating thread will try again itself and report the error.
+            }
+            lock.lock();
+            current = nullptr;
+            idle.notify_all();
+        }
+    }
+}
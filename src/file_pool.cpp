@@ -0,0 +1,204 @@
+#include "internal.h"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+file_pool* file_pool::open(const std::filesystem::path& path, const size_t capacity,
+                           const file_pool_options& options) {
+    return new file_backed_pool(open_file(path, file_backed_pool::get_file_size(capacity)), capacity, options);
+}
+
+file_pool* file_pool::open_shared(const std::string& name, const size_t capacity,
+                                  const file_pool_options& options) {
+    return new file_backed_pool(open_shared_memory(name, file_backed_pool::get_file_size(capacity)), capacity,
+                                options);
+}
+
+size_t file_backed_pool::get_file_size(const size_t capacity) {
+    const auto pageSize = get_page_size();
+    return pageSize + (capacity + pageSize - 1) / pageSize * pageSize;
+}
+
+file_backed_pool::file_backed_pool(const mapped_file& opened, const size_t capacity,
+                                   const file_pool_options& options)
+    : file(opened), created(opened.created) {
+    const auto fixed = options.mapping == file_mapping::Fixed;
+    try {
+        map_file(file, fixed && created ? options.baseAddress : nullptr);
+        if (created) {
+            header = new(file.buffer) file_pool_header{
+                0, file_pool_header::expectedVersion, capacity, get_page_size(),
+                reinterpret_cast<uint64_t>(file.buffer), 0, 0, 0, file_pool_header::noRoot
+            };
+            // Written last, so a pool still being created isn't taken for a finished one.
+            std::atomic_ref(header->magic).store(file_pool_header::expectedMagic, std::memory_order_release);
+        } else {
+            header = validate(file);
+            // A pool at a fixed address goes back where it was created.
+            auto* address = reinterpret_cast<char*>(header->baseAddress);
+            if (fixed && address != file.buffer) {
+                unmap_file(file);
+                map_file(file, address);
+                header = validate(file);
+            }
+        }
+    } catch (...) {
+        close_file(file);
+        throw;
+    }
+    data = file.buffer + header->dataOffset;
+    this->capacity = header->capacity;
+}
+
+file_backed_pool::~file_backed_pool() {
+    close_file(file);
+}
+
+file_pool_header* file_backed_pool::validate(const mapped_file& file) {
+    auto* header = std::launder(reinterpret_cast<file_pool_header*>(file.buffer));
+    if (file.size < sizeof(file_pool_header)) {
+        throw std::invalid_argument("File does not hold a pool");
+    }
+    // Another process may still be creating the pool.
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    uint64_t magic;
+    while ((magic = std::atomic_ref(header->magic).load(std::memory_order_acquire)) == 0 &&
+           std::chrono::steady_clock::now() < giveUp) {
+        std::this_thread::yield();
+    }
+    if (magic != file_pool_header::expectedMagic) {
+        throw std::invalid_argument("File does not hold a pool");
+    }
+    if (header->version != file_pool_header::expectedVersion) {
+        throw std::invalid_argument("File holds a pool from an unsupported version");
+    }
+    if (header->dataOffset % get_page_size() != 0 || header->dataOffset > file.size ||
+        header->capacity > file.size - header->dataOffset) {
+        throw std::invalid_argument("File holds a damaged pool");
+    }
+    return header;
+}
+
+bool file_backed_pool::is_new() const {
+    return created;
+}
+
+void* file_backed_pool::get_root() const {
+    const auto offset = header->rootOffset.load(std::memory_order_acquire);
+    return offset == file_pool_header::noRoot ? nullptr : data + offset;
+}
+
+void file_backed_pool::set_root(void* root) {
+    header->rootOffset.store(root == nullptr ? file_pool_header::noRoot : to_offset(root),
+                             std::memory_order_release);
+}
+
+size_t file_backed_pool::to_offset(const void* pointer) const {
+    return static_cast<const char*>(pointer) - data;
+}
+
+void* file_backed_pool::from_offset(const size_t offset) const {
+    return data + offset;
+}
+
+void file_backed_pool::sync() {
+    sync_file(file, header->dataOffset + header->bytesInUse.load(std::memory_order_relaxed));
+}
+
+size_t file_backed_pool::get_capacity() const {
+    return capacity;
+}
+
+size_t file_backed_pool::get_size() const {
+    return header->bytesInUse.load(std::memory_order_relaxed);
+}
+
+size_t file_backed_pool::get_alignment_fragmentation() const {
+    return header->alignmentFragmentationBytes.load(std::memory_order_relaxed);
+}
+
+size_t file_backed_pool::get_committed_size() const {
+    return file.size - header->dataOffset;
+}
+
+size_t file_backed_pool::get_resident_size() const {
+    return get_resident_bytes(data, get_committed_size());
+}
+
+int file_backed_pool::get_numa_node() const {
+    return -1;
+}
+
+size_t file_backed_pool::get_peak_size() const {
+    return std::max<size_t>(header->peakBytesBeforeRewind.load(std::memory_order_relaxed),
+                            header->bytesInUse.load(std::memory_order_relaxed));
+}
+
+size_t file_backed_pool::trim() {
+    return 0;
+}
+
+void file_backed_pool::reset() {
+    rewind(pool_marker{});
+}
+
+pool_marker file_backed_pool::mark() const {
+    return {get_size(), get_alignment_fragmentation()};
+}
+
+void file_backed_pool::rewind(const pool_marker& marker) {
+    if (marker.position > get_size()) {
+        throw std::invalid_argument("Marker is past the pool's current position");
+    }
+    header->peakBytesBeforeRewind.store(get_peak_size(), std::memory_order_relaxed);
+    header->bytesInUse.store(marker.position, std::memory_order_relaxed);
+    header->alignmentFragmentationBytes.store(marker.alignmentFragmentation, std::memory_order_relaxed);
+}
+
+void* file_backed_pool::do_allocate(const std::size_t size, const std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    auto offset = header->bytesInUse.load(std::memory_order_relaxed);
+    size_t alignmentSkip;
+    size_t newOffset;
+    do {
+        if (capacity - offset < size) [[unlikely]] {
+            throwOutOfMemory(size, alignment, capacity - offset);
+        }
+        alignmentSkip = computeAlignmentSkip(data + offset, alignment);
+        if (capacity - offset - size < alignmentSkip) [[unlikely]] {
+            throwOutOfMemory(size, alignment, capacity - offset);
+        }
+        newOffset = offset + alignmentSkip + size;
+    } while (!header->bytesInUse.compare_exchange_weak(offset, newOffset, std::memory_order_acquire,
+                                                       std::memory_order_relaxed));
+
+    if (alignmentSkip != 0) {
+        header->alignmentFragmentationBytes.fetch_add(alignmentSkip, std::memory_order_relaxed);
+    }
+    return data + offset + alignmentSkip;
+}
+
+bool file_backed_pool::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    const auto start = reinterpret_cast<uintptr_t>(p);
+    const auto base = reinterpret_cast<uintptr_t>(data);
+    if (start < base || start - base > capacity || capacity - (start - base) < oldSize) {
+        return false;
+    }
+    // Only the allocation that ends at the pool's position can move it.
+    uint64_t offset = start - base + oldSize;
+    if (newSize > oldSize && capacity - offset < newSize - oldSize) {
+        return false;
+    }
+    if (!header->bytesInUse.compare_exchange_strong(offset, offset - oldSize + newSize, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed)) {
+        return false;
+    }
+    if (newSize < oldSize) {
+        // Save the peak that shrinking lowered, unless another thread saved a higher one.
+        auto peak = header->peakBytesBeforeRewind.load(std::memory_order_relaxed);
+        while (peak < offset &&
+               !header->peakBytesBeforeRewind.compare_exchange_weak(peak, offset, std::memory_order_relaxed)) {
+        }
+    }
+    return true;
+}
@@ -1,61 +1,444 @@
 #pragma once
 #include "memory-pool/memory_pool.h"
+#include "memory-pool/basic_pool.h"
+#include "memory-pool/file_pool.h"
+#include "metrics.h"
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <type_traits>
 
 using namespace memory_pool;
 
-class simple_pool : public pool {
-    const size_t totalCapacity;
-    size_t commitAheadBytes;
-    size_t bytesInUse = 0;
-    char* buffer; // Page-aligned.
-    char* firstCommittedUnusedByte;
-    char* firstUncommittedByte; // Page-aligned.
-    size_t alignmentFragmentationBytes = 0;
-    // low address ---uuuuuuuuuuuuuuuuuuuuuuccccccccccccccccccccccrrrrrrrrrrrrrrrrr----- high address
-    //                ^                     ^                     ^
-    //                buffer               firstCommittedUnused   firstUncommitted
-    // u = in use
-    // c = committed (not in use)
-    // r = reserved (not in use, not committed)
+[[noreturn]] void throwOutOfMemory(size_t size, size_t alignment, size_t freeBytes);
+
+// Gets how many bytes past pointer the next address with the given alignment is.
+[[nodiscard]] size_t computeAlignmentSkip(const char* pointer, size_t alignment);
 
+// A pool that the background committer keeps committed ahead of its allocations.
+class background_commit_target {
 public:
-    explicit simple_pool(size_t capacity);
+    virtual ~background_commit_target() = default;
 
-    ~simple_pool() override;
+    // Commits and prefaults up to the pool's background commit window past its first unused byte.
+    virtual void commit_in_background() = 0;
 
-    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+    std::atomic<bool> commitRequested = false;
+};
 
-    [[nodiscard]] size_t get_size() const override;
+// Commits memory for pools on a background thread, so that allocating threads rarely enter the kernel.
+// The thread runs only while some pool is registered with it.
+class background_committer {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle; // Signaled when the worker finishes with a target, or finishes stopping.
+    std::vector<background_commit_target*> targets;
+    background_commit_target* current = nullptr; // The target the worker is committing for, if any.
+    std::thread worker;
+    bool requested = false;
+    bool stopping = false;
 
-    [[nodiscard]] size_t get_capacity() const override;
+public:
+    [[nodiscard]] static background_committer& instance();
+
+    ~background_committer();
+
+    void add(background_commit_target* target);
+
+    // When this returns, the worker is not using the target and never will again.
+    void remove(background_commit_target* target);
+
+    // Asks the worker to commit for the target soon.
+    void request(background_commit_target* target);
+
+private:
+    void run();
+};
+
+// Reservations that destroyed pools left for new pools to take, so creating and destroying pools of one size
+// doesn't map, commit and unmap memory each time.
+class reservation_cache {
+public:
+    struct entry {
+        char* buffer;
+        size_t size;
+        huge_pages hugePages;
+        commit_mode commitMode;
+        size_t committedBytes;
+    };
+
+private:
+    std::mutex mutex;
+    reservation_cache_options options;
+    std::vector<entry> entries; // Oldest first.
+    size_t cachedBytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+public:
+    [[nodiscard]] static reservation_cache& instance();
+
+    // Returns the entries that no longer fit the new limits, for the caller to free.
+    [[nodiscard]] std::vector<entry> configure(const reservation_cache_options& newOptions);
+
+    [[nodiscard]] reservation_cache_statistics get_statistics();
+
+    [[nodiscard]] reservation_cache_options get_options();
+
+    // Takes a reservation of exactly this size, huge pages and commit mode, or returns false if there is none.
+    [[nodiscard]] bool take(size_t size, huge_pages hugePages, commit_mode commitMode, entry& taken);
+
+    // Caches a reservation, evicting the oldest ones to make room. Returns the reservations the caller must free:
+    // the evicted ones, and the given one if the cache can't hold it.
+    [[nodiscard]] std::vector<entry> put(const entry& released);
+};
+
+// State a pool keeps for one thread that uses it.
+class thread_entry {
+public:
+    virtual ~thread_entry() = default;
+
+    std::atomic<thread_entry*> next = nullptr; // Links the entries of a registry.
+};
+
+// A thread's entry in a registry, as the thread remembers it.
+struct found_entry {
+    uint64_t registryId = UINT64_MAX;
+    thread_entry* entry = nullptr;
+};
+
+// The entry the calling thread found last, so that looking it up again costs one compare.
+inline constinit thread_local found_entry lastFoundEntry;
+
+// Tracks the per-thread state a pool hands out. A thread's entry is destroyed when the thread exits or when the
+// registry is destroyed, whichever comes first.
+class thread_registry {
+public:
+    // Runs on an exiting thread, with the registry locked, just before the thread's entry is destroyed.
+    using exit_handler = std::function<void(thread_entry&)>;
+
+    struct shared_state {
+        std::mutex mutex; // Held while adding or removing entries. Unlocked readers don't take it.
+        bool alive = true; // Cleared when the registry is destroyed, so exiting threads leave its entries alone.
+        std::atomic<thread_entry*> head = nullptr;
+        std::atomic<size_t> unlockedReaders = 0;
+        std::vector<thread_entry*> retired; // Removed entries that an unlocked reader may still be looking at.
+        exit_handler onThreadExit;
+
+        ~shared_state();
+
+        // Unlinks an entry and frees it once no unlocked reader can be looking at it. Must hold the mutex.
+        void remove(thread_entry* entry);
+
+        // Frees every entry. Must hold the mutex.
+        void clear();
+    };
+
+    explicit thread_registry(exit_handler onThreadExit = nullptr);
+
+    thread_registry(const thread_registry&) = delete;
+
+    ~thread_registry();
+
+    // Gets the calling thread's entry, or nullptr if it doesn't have one yet.
+    [[nodiscard]] thread_entry* find() const {
+        if (lastFoundEntry.registryId == id) [[likely]] {
+            return lastFoundEntry.entry;
+        }
+        return find_slow();
+    }
+
+    // Makes the given entry the calling thread's entry, and returns it.
+    thread_entry* add(std::unique_ptr<thread_entry> entry);
+
+    // Calls f on every entry, with the registry locked.
+    template<typename F>
+    void for_each(F&& f) const {
+        std::lock_guard lock(state->mutex);
+        for (auto* entry = state->head.load(std::memory_order_relaxed); entry != nullptr;
+             entry = entry->next.load(std::memory_order_relaxed)) {
+            f(*entry);
+        }
+    }
+
+    // Calls f on every entry without locking the registry, so threads can come and go meanwhile. An entry f is
+    // given stays alive until f returns, but its thread may be exiting.
+    template<typename F>
+    void for_each_unlocked(F&& f) const {
+        // Removal checks for readers after unlinking, so everything here is sequentially consistent.
+        struct reader {
+            std::atomic<size_t>& readers;
+
+            ~reader() { readers.fetch_sub(1); }
+        };
+
+        state->unlockedReaders.fetch_add(1);
+        reader guard{state->unlockedReaders};
+        for (auto* entry = state->head.load(); entry != nullptr; entry = entry->next.load()) {
+            f(*entry);
+        }
+    }
+
+private:
+    const std::shared_ptr<shared_state> state; // Shared with the threads that have entries.
+    const uint64_t id; // Unlike this registry's address, never reused by another registry.
+    const size_t slot; // Where threads keep their entry in this registry. Reused once this registry is destroyed.
+
+    // Looks the entry up by slot, and caches it.
+    [[nodiscard]] thread_entry* find_slow() const;
+};
+
+// Threading policy for a basic_pool that one thread allocates from while the background committer commits for it.
+// Other threads read the pool's state, so values are atomic, but only the allocating thread changes them.
+struct single_allocator {
+    template<typename T>
+    class cell {
+        std::atomic<T> value;
+
+    public:
+        explicit cell(T value)
+            : value(value) {
+        }
+
+        [[nodiscard]] T load(const std::memory_order order = std::memory_order_relaxed) const {
+            return value.load(order);
+        }
+
+        void store(T desired, const std::memory_order order = std::memory_order_relaxed) {
+            value.store(desired, order);
+        }
+
+        void add(T amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        void subtract(T amount) {
+            value.store(value.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed);
+        }
+
+        // Always succeeds, since no other thread can have changed the value.
+        bool compare_exchange(T&, T desired) {
+            value.store(desired, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    using commit_mutex = std::mutex; // Shared with the background committer.
+};
+
+// Commit policy for the pools behind pool::create, chosen from their options.
+struct configured_commit {
+    commit_mode commitMode;
+    size_t chunkBytes;
+    size_t backgroundCommitBytes;
+    background_commit_target* target;
+
+    // With a background committer, allocations come to commit early enough to ask it for more before they run out.
+    [[nodiscard]] size_t get_commit_margin() const {
+        return backgroundCommitBytes / 2;
+    }
+
+    // Asks the background committer, if the pool has one, to commit soon.
+    bool request_commit() const;
+};
+
+// The pools behind pool_type::SingleThreaded and ThreadSafe: basic_pools configured at run time, with huge pages,
+// NUMA placement, background commit, trimming and the reservation cache.
+template<typename ThreadingPolicy>
+class configured_pool final : public basic_pool<ThreadingPolicy, configured_commit>, background_commit_target {
+    using base = basic_pool<ThreadingPolicy, configured_commit>;
+
+    // A reservation made for the pool before it's constructed, already placed and partly committed.
+    struct reservation {
+        char* buffer;
+        size_t reservedBytes;
+        size_t committedBytes;
+        int numaNode;
+    };
+
+    const size_t pageSize;
+    const huge_pages hugePages;
+    const numa_policy numaPolicy;
+    const decommit_policy decommitPolicy;
+    const size_t warmReserveBytes;
+    const bool trimOnRewind;
+    const int numaNode;
+
+public:
+    // For numa_policy::Local, preferredNode is the node to prefer, or -1 for the calling thread's.
+    configured_pool(size_t capacity, const pool_options& options, int preferredNode = -1);
+
+    ~configured_pool() override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    // Must not be called while other threads allocate from the pool.
+    size_t trim() override;
+
+    // Must not be called while other threads allocate from the pool.
+    void rewind(const pool_marker& marker) override;
 
     void* do_allocate(std::size_t bytes, std::size_t alignment) override;
 
+    using base::try_allocate;
+
+    using base::do_resize;
+
+    void commit_in_background() override;
+
 private:
-    void printStats();
+    configured_pool(size_t capacity, const pool_options& options, const reservation& reserved);
+
+    [[nodiscard]] static reservation reserve(size_t capacity, const pool_options& options, int preferredNode);
 };
 
+using simple_pool = configured_pool<single_allocator>;
+
+using lock_free_pool = configured_pool<thread_safe>;
+
 class locked_pool : public pool {
     simple_pool pool;
     mutable std::mutex mutex;
 
     void* do_allocate(std::size_t size, std::size_t alignment) override;
 
+    [[nodiscard]] bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
 public:
 
     [[nodiscard]] size_t get_alignment_fragmentation() const override;
 
-    explicit locked_pool(size_t capacity);
+    locked_pool(size_t capacity, const pool_options& options);
+
+    ~locked_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    size_t trim() override;
+
+    void reset() override;
+
+    [[nodiscard]] pool_marker mark() const override;
+
+    void rewind(const pool_marker& marker) override;
+};
+
+class buffered_pool : public pool {
+    // The part of the shared capacity one thread is currently allocating from.
+    struct thread_buffer : thread_entry {
+        char* cursor = nullptr;
+        char* end = nullptr;
+        // Written only by the owning thread, so other threads can read them for statistics.
+        std::atomic<size_t> unusedBytes = 0;
+        std::atomic<size_t> alignmentFragmentationBytes = 0;
+    };
+
+    lock_free_pool shared;
+    const size_t threadBufferSize;
+    // What exited threads left of their buffers, for new threads to take over.
+    std::mutex leftoversMutex;
+    std::vector<std::pair<char*, char*>> leftovers;
+    std::atomic<size_t> leftoverBytes = 0;
+    std::atomic<size_t> exitedAlignmentFragmentationBytes = 0;
+    thread_registry buffers; // Last, so exiting threads stop leaving buffers behind before the rest is destroyed.
+
+public:
+    buffered_pool(size_t capacity, const pool_options& options);
+
+    ~buffered_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    // Bytes left at the end of a thread's buffer when it takes a new one count as in use.
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    // Must not be called while other threads allocate from the pool.
+    size_t trim() override;
+
+    // Must not be called while other threads allocate from the pool.
+    void reset() override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    [[nodiscard]] thread_buffer* get_thread_buffer();
+
+    // Allocates from the calling thread's buffer, refilling it if needed.
+    void* allocate_from_buffer(std::size_t size, std::size_t alignment);
+
+    void* refill_and_allocate(thread_buffer* buffer, std::size_t size, std::size_t alignment);
+
+    // Allocates from the shared pool without counting it as an allocation.
+    void* take_from_shared(std::size_t size, std::size_t alignment);
+};
+
+class pool_per_cpu : public pool {
+    struct alignas(64) shard {
+        std::mutex mutex;
+        simple_pool pool;
+
+        shard(size_t capacity, const pool_options& options, int numaNode);
+    };
+
+    // Fixed when the pool is created.
+    std::vector<std::unique_ptr<shard>> shards;
+
+public:
+    pool_per_cpu(size_t capacity, const pool_options& options);
+
+    ~pool_per_cpu() override;
 
     [[nodiscard]] size_t get_capacity() const override;
 
     [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    size_t trim() override;
+
+    void reset() override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
 };
 
 class pool_per_thread : public pool {
 public:
-    explicit pool_per_thread(size_t capacity);
+    pool_per_thread(size_t capacity, const pool_options& options);
 
     [[nodiscard]] size_t get_capacity() const override;
 
@@ -63,12 +446,392 @@ public:
 
     [[nodiscard]] size_t get_alignment_fragmentation() const override;
 
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    size_t trim() override;
+
+    void reset() override;
+
+    [[nodiscard]] pool_marker mark() const override;
+
+    void rewind(const pool_marker& marker) override;
+
+    [[nodiscard]] pool_statistics get_statistics() const override;
+
 private:
     void* do_allocate(std::size_t size, std::size_t alignment) override;
 
+    [[nodiscard]] bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
+    // Objects belong to the pool of the thread that created them.
+    [[nodiscard]] pool& get_destructor_owner() override;
+
     [[nodiscard]] pool* get_thread_local_pool() const;
 
     [[nodiscard]] pool* create_pool() const;
 
+    // Set before the entry is added, and not changed after, so unlocked readers can use them.
+    struct thread_pool : thread_entry {
+        std::unique_ptr<pool> threadPool;
+        std::thread::id threadId = std::this_thread::get_id();
+    };
+
+    // Gets the calling thread's pool, or nullptr if it doesn't have one yet.
+    [[nodiscard]] const pool* find_thread_local_pool() const;
+
+    const size_t totalCapacity;
+    const pool_options options;
+    // Each thread's pool is freed when the thread exits, or when this pool is destroyed.
+    mutable thread_registry threadPools;
+};
+
+class slab_pool : public pool {
+public:
+    static constexpr size_t minBlockShift = 4; // 16 bytes, enough for a free list link.
+    static constexpr size_t maxBlockShift = 20; // 1 MiB. Larger blocks are never reused.
+    static constexpr size_t classCount = maxBlockShift - minBlockShift + 1;
+    static constexpr size_t maxBlockAlignment = 4096; // Blocks are aligned to their size, up to this.
+
+private:
+    struct free_block {
+        free_block* next;
+    };
+
+    struct alignas(64) free_list {
+        mutable std::mutex mutex;
+        free_block* head = nullptr;
+        size_t count = 0;
+    };
+
+    // The free blocks one thread keeps to itself, so it can allocate and deallocate without locking.
+    struct thread_cache : thread_entry {
+        free_block* heads[classCount] = {};
+        size_t counts[classCount] = {};
+        // Written only by the owning thread, so other threads can read it for statistics.
+        std::atomic<size_t> cachedBytes = 0;
+    };
+
+    lock_free_pool arena; // Where blocks are carved from.
+    free_list freeLists[classCount]; // Blocks shared between threads, moved to and from thread caches in batches.
+    thread_registry threads; // Last, so exiting threads stop using the free lists before they are destroyed.
+
+public:
+    slab_pool(size_t capacity, const pool_options& options);
+
+    ~slab_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    // Blocks waiting on a free list don't count as in use. Blocks count in whole size classes.
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    // Must not be called while other threads allocate from the pool.
+    size_t trim() override;
+
+    // Must not be called while other threads use the pool.
+    void reset() override;
+
+    // Gets the size class that serves the given request, or classCount if it's too big to reuse or its alignment
+    // isn't a power of 2.
+    [[nodiscard]] static size_t get_size_class(std::size_t size, std::size_t alignment);
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    void do_deallocate(void* p, std::size_t size, std::size_t alignment) override;
+
+    // Takes each buffer from the size class's blocks, so each can be deallocated and reused on its own.
+    void do_allocate_bulk(std::size_t count, std::size_t size, std::size_t alignment, void** out) override;
+
+    [[nodiscard]] thread_cache* get_thread_cache();
+
+    // Allocates from the arena without counting it as an allocation.
+    void* take_from_arena(std::size_t size, std::size_t alignment);
+
+    // Fills the cache's list for a size class from the shared free list, or by carving new blocks.
+    void refill(thread_cache& cache, size_t sizeClass);
+
+    // Moves up to count blocks from the cache's list for a size class to the shared free list.
+    void flush(thread_cache& cache, size_t sizeClass, size_t count);
+
+    // The most blocks a thread cache holds for a size class before giving some back.
+    [[nodiscard]] static size_t get_cache_limit(size_t sizeClass);
+
+    [[nodiscard]] static size_t get_block_size(size_t sizeClass);
+};
+
+// A pool that chains more segments, each a pool of its own, when the last one is full.
+// Segment is simple_pool for a single thread, or lock_free_pool to allocate from many threads at once.
+template<typename Segment>
+class growable_pool : public pool {
+    const pool_options options;
+    const size_t maxCapacity; // 0 means no limit.
+    std::atomic<Segment*> current; // The last segment.
+    mutable std::mutex segmentsMutex; // Held while adding segments or reading them for statistics.
+    std::vector<std::unique_ptr<Segment>> segments;
+    size_t peakBytesBeforeRewind = 0; // Saves the peak when a rewind frees segments.
+
+public:
+    growable_pool(size_t capacity, const pool_options& options);
+
+    ~growable_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    // Bytes left at the end of a segment when the pool moves on to the next one don't count as in use.
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    // Must not be called while other threads allocate from the pool.
+    size_t trim() override;
+
+    // Frees every segment but the first. Must not be called while other threads allocate from the pool.
+    void reset() override;
+
+    // The marker's position counts every byte of the segments before the current one.
+    [[nodiscard]] pool_marker mark() const override;
+
+    // Frees the segments added since the marker was taken. Must not be called while other threads allocate
+    // from the pool.
+    void rewind(const pool_marker& marker) override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    [[nodiscard]] bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
+    // Adds a segment that can fit the request, unless another thread already added one, and allocates from it.
+    void* grow_and_allocate(Segment* full, std::size_t size, std::size_t alignment);
+
+    // Sums a statistic over all segments.
+    template<typename F>
+    [[nodiscard]] size_t sum(F&& f) const {
+        std::lock_guard lock(segmentsMutex);
+        size_t total = 0;
+        for (const auto& segment : segments) {
+            total += f(*segment);
+        }
+        return total;
+    }
+};
+
+// A pool that serves allocations from a caller's buffer, and reserves memory only once the buffer is full.
+template<typename Backing>
+class initial_buffer_pool : public pool {
+    using threading = std::conditional_t<std::is_same_v<Backing, simple_pool>, single_threaded, thread_safe>;
+
+    template<typename T>
+    using cell = typename threading::template cell<T>;
+
     const size_t totalCapacity;
+    const pool_options options;
+    basic_pool<threading, commit_on_fault> initial; // Allocates from the caller's buffer.
+    // Set once an allocation didn't fit in the buffer. Later allocations all come from the backing pool.
+    cell<bool> initialBufferClosed{false};
+    cell<Backing*> backing{nullptr};
+    std::unique_ptr<Backing> ownedBacking;
+    typename threading::commit_mutex backingMutex; // Held while creating the backing pool.
+    cell<size_t> peakBytesBeforeRewind{0};
+
+public:
+    initial_buffer_pool(size_t capacity, const pool_options& options, void* initialBuffer, size_t initialBufferSize);
+
+    ~initial_buffer_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    // Bytes left at the end of the buffer when the pool moves on to the backing pool don't count as in use.
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    // Counts the whole buffer, which is usable without a system call.
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    // Counts only the backing pool's memory.
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    size_t trim() override;
+
+    // Keeps the backing pool, if there is one, for reuse.
+    void reset() override;
+
+    // Once the buffer is closed, the marker's position counts every byte of it.
+    [[nodiscard]] pool_marker mark() const override;
+
+    void rewind(const pool_marker& marker) override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    // Resizes in whichever of the buffer and the backing pool allocations come from now.
+    [[nodiscard]] bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
+    [[nodiscard]] Backing* get_or_create_backing();
+};
+
+// A pool made by pool::create_child. It allocates from one block at the end of its parent, growing the block with
+// try_extend. When the parent has allocated after the block, or can't resize allocations at all, the child moves on
+// to a new block at the parent's end, and the old block stays with the parent until the parent is reset.
+class child_pool final : public pool {
+    pool& parent;
+    const size_t capacity;
+    char* blockStart = nullptr; // Null until the first allocation, and after rewinding past the block's start.
+    size_t blockSize = 0; // Bytes of the block taken from the parent.
+    size_t blockUsed = 0; // Bytes of the block allocated. Less than blockSize after rewinding into a block the
+                          // parent couldn't shrink.
+    size_t blockStartPosition = 0; // The child's position at the start of the block.
+    std::atomic<size_t> bytesInUse = 0;
+    std::atomic<size_t> alignmentFragmentationBytes = 0;
+    size_t peakBytesBeforeRewind = 0;
+
+public:
+    child_pool(pool& parent, size_t capacity);
+
+    ~child_pool() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    // Counts the current block, which the parent has already committed.
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    // Counts the pages the current block touches.
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    // Gives nothing back: the parent owns the pages.
+    size_t trim() override;
+
+    void reset() override;
+
+    [[nodiscard]] pool_marker mark() const override;
+
+    void rewind(const pool_marker& marker) override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
+    // Forgets the current block, which must hold no allocations, giving it back to the parent if the parent can
+    // shrink it.
+    void release_block();
+};
+
+// The first page of a file_pool's file. The pool's data follows it.
+struct file_pool_header {
+    static constexpr uint64_t expectedMagic = 0x6C6F6F702D6D656D; // "mem-pool"
+    static constexpr uint64_t expectedVersion = 1;
+    static constexpr uint64_t noRoot = UINT64_MAX;
+
+    uint64_t magic;
+    uint64_t version;
+    uint64_t capacity;
+    uint64_t dataOffset; // From the start of the file: the page size when it was created.
+    uint64_t baseAddress; // Where the file was mapped when it was created.
+    std::atomic<uint64_t> bytesInUse;
+    std::atomic<uint64_t> alignmentFragmentationBytes;
+    std::atomic<uint64_t> peakBytesBeforeRewind;
+    std::atomic<uint64_t> rootOffset; // From the start of the data, or noRoot.
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The header's atomics must live in the file");
+};
+
+class file_backed_pool final : public file_pool {
+    mapped_file file;
+    file_pool_header* header;
+    char* data; // Page-aligned.
+    size_t capacity;
+    bool created;
+
+public:
+    // Maps a file opened by open_file or open_shared_memory, and takes ownership of it.
+    file_backed_pool(const mapped_file& opened, size_t capacity, const file_pool_options& options);
+
+    // Gets the size of a file that holds a pool with the given capacity.
+    [[nodiscard]] static size_t get_file_size(size_t capacity);
+
+    ~file_backed_pool() override;
+
+    [[nodiscard]] bool is_new() const override;
+
+    [[nodiscard]] void* get_root() const override;
+
+    void set_root(void* root) override;
+
+    [[nodiscard]] size_t to_offset(const void* pointer) const override;
+
+    [[nodiscard]] void* from_offset(size_t offset) const override;
+
+    void sync() override;
+
+    [[nodiscard]] size_t get_capacity() const override;
+
+    [[nodiscard]] size_t get_size() const override;
+
+    [[nodiscard]] size_t get_alignment_fragmentation() const override;
+
+    // Counts the whole file, which is usable up front.
+    [[nodiscard]] size_t get_committed_size() const override;
+
+    [[nodiscard]] size_t get_resident_size() const override;
+
+    [[nodiscard]] int get_numa_node() const override;
+
+    [[nodiscard]] size_t get_peak_size() const override;
+
+    // Gives nothing back: the unused part of the file holds no data, but stays mapped.
+    size_t trim() override;
+
+    // Must not be called while other threads allocate from the pool.
+    void reset() override;
+
+    [[nodiscard]] pool_marker mark() const override;
+
+    // Must not be called while other threads allocate from the pool.
+    void rewind(const pool_marker& marker) override;
+
+private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+
+    [[nodiscard]] bool do_resize(void* p, std::size_t oldSize, std::size_t newSize) override;
+
+    // Checks that an existing file holds a pool, and returns its header.
+    [[nodiscard]] static file_pool_header* validate(const mapped_file& file);
 };
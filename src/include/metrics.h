@@ -0,0 +1,52 @@
+#pragma once
+#include "memory-pool/memory_pool.h"
+#include <mutex>
+
+// Records the counters behind pool::get_metrics. Without MEMORY_POOL_METRICS, everything here compiles to nothing.
+namespace metrics {
+#ifdef MEMORY_POOL_METRICS
+    void record_allocation(size_t size, size_t alignment);
+
+    void record_deallocation();
+
+    void record_commit(uint64_t nanoseconds);
+
+    void record_lock_wait(uint64_t nanoseconds);
+
+    [[nodiscard]] uint64_t now_nanoseconds();
+
+    // Times a commit system call made in its scope.
+    class commit_timer {
+        const uint64_t start = now_nanoseconds();
+
+    public:
+        ~commit_timer() { record_commit(now_nanoseconds() - start); }
+    };
+
+    // Locks a mutex, timing how long it takes if it's held by another thread.
+    template<typename Mutex>
+    [[nodiscard]] std::unique_lock<Mutex> lock(Mutex& mutex) {
+        std::unique_lock lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            const auto start = now_nanoseconds();
+            lock.lock();
+            record_lock_wait(now_nanoseconds() - start);
+        }
+        return lock;
+    }
+#else
+    inline void record_allocation(size_t, size_t) {
+    }
+
+    inline void record_deallocation() {
+    }
+
+    class commit_timer {
+    };
+
+    template<typename Mutex>
+    [[nodiscard]] std::unique_lock<Mutex> lock(Mutex& mutex) {
+        return std::unique_lock(mutex);
+    }
+#endif
+}
@@ -1,20 +1,36 @@
 #ifdef __linux__
+#include <algorithm>
+#include <fstream>
+#include <string>
 #include <stdexcept>
 #include <system_error>
 #include <unistd.h>
 
 #include "internal.h"
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <linux/mempolicy.h>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 using namespace memory_pool;
 
+char* mapAnonymous(const size_t size, const int protection, const int flags) {
+    return static_cast<char*>(mmap(nullptr,
+                                   size,
+                                   protection,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | flags,
+                                   -1,
+                                   0));
+}
+
 char* pool::reserve_buffer(const size_t size) {
-    auto* ret = static_cast<char*>(mmap(nullptr,
-                                        size,
-                                        PROT_NONE,
-                                        MAP_PRIVATE | MAP_ANONYMOUS,
-                                        -1,
-                                        0));
+    auto* ret = mapAnonymous(size, PROT_NONE, 0);
     if (ret == MAP_FAILED) {
         throw std::system_error(errno, std::generic_category(),
                                 "Failed to allocate memory");
@@ -22,6 +38,44 @@ char* pool::reserve_buffer(const size_t size) {
     return ret;
 }
 
+char* pool::reserve_buffer(const size_t size, const huge_pages hugePages, const commit_mode commitMode) {
+    // In Fault mode the whole reservation is usable up front, and pages are committed when first written.
+    // MAP_NORESERVE keeps the kernel from charging the whole reservation against the commit limit.
+    const auto protection = commitMode == commit_mode::Fault ? PROT_READ | PROT_WRITE : PROT_NONE;
+    const auto flags = commitMode == commit_mode::Fault ? MAP_NORESERVE : 0;
+    if (hugePages == huge_pages::Explicit) {
+        auto* ret = mapAnonymous(size, protection, flags | MAP_HUGETLB);
+        if (ret != MAP_FAILED) {
+            return ret;
+        }
+        // Not enough huge pages are set aside, so fall back to transparent ones.
+    }
+    if (hugePages == huge_pages::None) {
+        auto* ret = mapAnonymous(size, protection, flags);
+        if (ret == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to allocate memory");
+        }
+        return ret;
+    }
+
+    // Over-reserve so we can trim the reservation to a huge page boundary on both ends.
+    const auto hugePageSize = get_huge_page_size();
+    auto* reserved = mapAnonymous(size + hugePageSize, protection, flags);
+    if (reserved == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to allocate memory");
+    }
+    auto* ret = get_containing_page(reserved + hugePageSize - 1, hugePageSize);
+    if (ret != reserved) {
+        free_buffer(reserved, ret - reserved);
+    }
+    free_buffer(ret + size, (reserved + size + hugePageSize) - (ret + size));
+    // This fails if transparent huge pages are disabled, in which case we just get base pages.
+    (void)madvise(ret, size, MADV_HUGEPAGE);
+    return ret;
+}
+
 size_t getPageSize() {
     return sysconf(_SC_PAGESIZE);
 }
@@ -30,19 +84,186 @@ size_t pool::get_page_size() {
     return getPageSize();
 }
 
+size_t readHugePageSize() {
+    size_t size = 0;
+    std::ifstream("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size") >> size;
+    if (size != 0) {
+        return size;
+    }
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    while (meminfo >> key) {
+        if (key == "Hugepagesize:" && meminfo >> size) {
+            return size * 1024;
+        }
+    }
+    return 2 * 1024 * 1024;
+}
+
+size_t pool::get_huge_page_size() {
+    static const size_t hugePageSize = readHugePageSize();
+    return hugePageSize;
+}
+
 char* pool::get_containing_page(char* pointer) {
     static const uintptr_t pageMaskOn = ~(get_page_size() - 1);
     return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(pointer) & pageMaskOn);
  }
 
+char* pool::get_containing_page(char* pointer, const size_t pageSize) {
+    return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(pointer) & ~(pageSize - 1));
+}
+
+size_t pool::get_current_cpu() {
+    // Recent glibc answers this from the thread's rseq area without a syscall.
+    const auto cpu = sched_getcpu();
+    return cpu < 0 ? 0 : static_cast<size_t>(cpu);
+}
+
+size_t pool::get_cpu_count() {
+    const auto count = sysconf(_SC_NPROCESSORS_CONF);
+    return count < 1 ? 1 : static_cast<size_t>(count);
+}
+
+int pool::get_cpu_numa_node(const size_t cpu) {
+    // The CPU's sysfs directory links to its node, as nodeN.
+    std::error_code error;
+    const std::filesystem::path cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto& entry : std::filesystem::directory_iterator(cpuPath, error)) {
+        const auto name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node") &&
+            std::all_of(name.begin() + 4, name.end(), [](const char c) { return c >= '0' && c <= '9'; })) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return -1;
+}
+
+using node_mask = std::vector<unsigned long>;
+constexpr size_t bitsPerMaskWord = sizeof(unsigned long) * 8;
+
+void addToNodeMask(node_mask& mask, const size_t node) {
+    if (mask.size() <= node / bitsPerMaskWord) {
+        mask.resize(node / bitsPerMaskWord + 1);
+    }
+    mask[node / bitsPerMaskWord] |= 1UL << (node % bitsPerMaskWord);
+}
+
+// Reads the nodes that are online, in the kernel's list format (e.g. "0-1,3").
+node_mask readOnlineNodes() {
+    node_mask mask;
+    std::string list;
+    std::ifstream("/sys/devices/system/node/online") >> list;
+    size_t position = 0;
+    while (position < list.size()) {
+        size_t length;
+        const auto first = std::stoul(list.substr(position), &length);
+        position += length;
+        auto last = first;
+        if (position < list.size() && list[position] == '-') {
+            last = std::stoul(list.substr(position + 1), &length);
+            position += length + 1;
+        }
+        for (auto node = first; node <= last; ++node) {
+            addToNodeMask(mask, node);
+        }
+        ++position; // Skip the comma.
+    }
+    if (mask.empty()) {
+        addToNodeMask(mask, 0);
+    }
+    return mask;
+}
+
+bool bindMemory(char* buffer, const size_t size, const int mode, const node_mask& mask) {
+    // The kernel reads one bit less than maxnode says.
+    const auto maxNode = mask.size() * bitsPerMaskWord + 1;
+    return syscall(SYS_mbind, buffer, size, mode, mask.data(), maxNode, 0) == 0;
+}
+
+int pool::set_numa_policy(char* buffer, const size_t size, const numa_policy policy, int node) {
+    // The policy is only a placement hint, so if the kernel refuses it (no NUMA support, or not permitted in a
+    // container) we carry on with the default placement.
+    switch (policy) {
+        case numa_policy::Local: {
+            if (node < 0) {
+                unsigned cpu;
+                unsigned currentNode;
+                if (syscall(SYS_getcpu, &cpu, &currentNode, nullptr) != 0) {
+                    return -1;
+                }
+                node = static_cast<int>(currentNode);
+            }
+            node_mask mask;
+            addToNodeMask(mask, node);
+            return bindMemory(buffer, size, MPOL_PREFERRED, mask) ? node : -1;
+        }
+        case numa_policy::Interleave:
+            (void)bindMemory(buffer, size, MPOL_INTERLEAVE, readOnlineNodes());
+            return -1;
+        default:
+            return -1;
+    }
+}
 
 void pool::allocate_reservation(char* buffer, const size_t size) {
+    [[maybe_unused]] metrics::commit_timer timer;
     if (mprotect(buffer, size, PROT_READ | PROT_WRITE) == -1) {
         throw std::system_error(errno, std::generic_category(),
                                 "Failed to allocate memory");
     }
 }
 
+void pool::prefault_pages(char* buffer, const size_t size) {
+    [[maybe_unused]] metrics::commit_timer timer;
+#ifdef MADV_POPULATE_WRITE
+    // Kernels before 5.14 reject this. The pages then just fault in when they are first written.
+    (void)madvise(buffer, size, MADV_POPULATE_WRITE);
+#endif
+}
+
+void pool::commit_pages(char* buffer, const size_t size, const commit_mode commitMode) {
+    if (commitMode == commit_mode::Fault) {
+        prefault_pages(buffer, size);
+    } else {
+        allocate_reservation(buffer, size);
+    }
+}
+
+void pool::release_pages(char* buffer, const size_t size, const decommit_policy policy) {
+#ifdef MADV_FREE
+    if (policy == decommit_policy::Free && madvise(buffer, size, MADV_FREE) == 0) {
+        return;
+    }
+    // Kernels before 4.5 reject MADV_FREE, so fall back to releasing the pages immediately.
+#endif
+    if (madvise(buffer, size, MADV_DONTNEED) == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to release memory");
+    }
+}
+
+size_t pool::get_resident_bytes(char* buffer, const size_t size) {
+    const auto pageSize = get_page_size();
+    unsigned char pageStates[4096];
+    size_t resident = 0;
+    for (size_t offset = 0; offset < size; offset += sizeof(pageStates) * pageSize) {
+        const auto length = std::min(size - offset, sizeof(pageStates) * pageSize);
+        if (mincore(buffer + offset, length, pageStates) == -1) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to query memory");
+        }
+        const auto pageCount = (length + pageSize - 1) / pageSize;
+        for (size_t i = 0; i < pageCount; ++i) {
+            if (pageStates[i] & 1) {
+                resident += pageSize;
+            }
+        }
+    }
+    // The last page may extend past the range.
+    return std::min(resident, size);
+}
+
 void pool::free_buffer(char* buffer, const size_t size) {
     if (munmap(buffer, size) == -1) {
         throw std::system_error(errno, std::generic_category(),
@@ -50,4 +271,141 @@ void pool::free_buffer(char* buffer, const size_t size) {
     }
 }
 
+// Gets the size of a file another process may have just created, waiting briefly for that process to size it.
+// Returns 0 if the file is still empty when the wait runs out.
+size_t waitForSize(const int fd, const char* failure) {
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (true) {
+        struct stat info{};
+        if (fstat(fd, &info) == -1) {
+            const auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), failure);
+        }
+        if (info.st_size != 0 || std::chrono::steady_clock::now() > giveUp) {
+            return static_cast<size_t>(info.st_size);
+        }
+        std::this_thread::yield();
+    }
+}
+
+file_pool::mapped_file file_pool::open_file(const std::filesystem::path& path, const size_t size) {
+    // Only the process that creates the file sizes it, so two processes opening it at once can't both.
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    mapped_file ret;
+    ret.created = fd != -1;
+    if (fd == -1 && errno == EEXIST) {
+        fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    }
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to open pool file");
+    }
+    ret.handle = fd;
+    if (!ret.created) {
+        ret.size = waitForSize(fd, "Failed to open pool file");
+        // A file that stays empty was never a pool, so it's as good as a new one.
+        ret.created = ret.size == 0;
+    }
+    if (ret.created) {
+        ret.size = size;
+    }
+    if (ret.created && ftruncate(fd, static_cast<off_t>(size)) == -1) {
+        const auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "Failed to size pool file");
+    }
+    return ret;
+}
+
+// Shared memory object names must start with a slash.
+std::string sharedMemoryName(const std::string& name) {
+    return name.starts_with('/') ? name : "/" + name;
+}
+
+file_pool::mapped_file file_pool::open_shared_memory(const std::string& name, const size_t size) {
+    mapped_file ret;
+    if (name.empty()) {
+        ret.handle = memfd_create("memory_pool", MFD_CLOEXEC);
+        ret.created = true;
+    } else {
+        // Only the process that creates the object sizes it, so two processes opening it at once can't both.
+        ret.handle = shm_open(sharedMemoryName(name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        ret.created = ret.handle != -1;
+        if (ret.handle == -1 && errno == EEXIST) {
+            ret.handle = shm_open(sharedMemoryName(name).c_str(), O_RDWR, 0);
+        }
+    }
+    if (ret.handle == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to open shared memory");
+    }
+    const auto fd = static_cast<int>(ret.handle);
+    if (ret.created) {
+        if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+            const auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(),
+                                    "Failed to size shared memory");
+        }
+        ret.size = size;
+        return ret;
+    }
+    ret.size = waitForSize(fd, "Failed to open shared memory");
+    if (ret.size == 0) {
+        close(fd);
+        throw std::system_error(ETIMEDOUT, std::generic_category(),
+                                "Shared memory was never sized by the process that created it");
+    }
+    return ret;
+}
+
+void file_pool::remove_shared(const std::string& name) {
+    if (shm_unlink(sharedMemoryName(name).c_str()) == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to remove shared memory");
+    }
+}
+
+void file_pool::map_file(mapped_file& file, void* address) {
+    auto flags = MAP_SHARED;
+#ifdef MAP_FIXED_NOREPLACE
+    if (address != nullptr) {
+        flags |= MAP_FIXED_NOREPLACE;
+    }
+#endif
+    auto* mapped = mmap(address, file.size, PROT_READ | PROT_WRITE, flags, static_cast<int>(file.handle), 0);
+    if (mapped == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to map pool file");
+    }
+    // Kernels before 4.17 take the address only as a hint.
+    if (address != nullptr && mapped != address) {
+        munmap(mapped, file.size);
+        throw std::system_error(EEXIST, std::generic_category(),
+                                "Failed to map pool file at its address");
+    }
+    file.buffer = static_cast<char*>(mapped);
+}
+
+void file_pool::unmap_file(mapped_file& file) {
+    free_buffer(file.buffer, file.size);
+    file.buffer = nullptr;
+}
+
+void file_pool::close_file(mapped_file& file) {
+    if (file.buffer != nullptr) {
+        unmap_file(file);
+    }
+    close(static_cast<int>(file.handle));
+}
+
+void file_pool::sync_file(const mapped_file& file, const size_t size) {
+    if (msync(file.buffer, size, MS_SYNC) == -1) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to sync pool file");
+    }
+}
+
 #endif
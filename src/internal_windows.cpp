@@ -4,6 +4,9 @@
 #include "internal.h"
 #define WIN32_LEAN_AND_MEAN
 #include "Windows.h"
+#include <psapi.h>
+#include <algorithm>
+#include <vector>
 
 using namespace memory_pool;
 
@@ -17,11 +20,46 @@ size_t pool::get_page_size() {
 	return getPageSize();
 }
 
+size_t pool::get_huge_page_size() {
+	const auto size = GetLargePageMinimum();
+	return size == 0 ? 2 * 1024 * 1024 : size;
+}
+
 char* pool::get_containing_page(char* pointer) {
 	static const uintptr_t pageMaskOn = ~(get_page_size() - 1);
 	return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(pointer) & pageMaskOn);
 }
 
+char* pool::get_containing_page(char* pointer, const size_t pageSize) {
+	return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(pointer) & ~(pageSize - 1));
+}
+
+size_t pool::get_current_cpu() {
+	return GetCurrentProcessorNumber();
+}
+
+size_t pool::get_cpu_count() {
+	return GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+}
+
+int pool::get_cpu_numa_node(const size_t cpu) {
+	PROCESSOR_NUMBER processor;
+	processor.Group = static_cast<WORD>(cpu / 64);
+	processor.Number = static_cast<BYTE>(cpu % 64);
+	processor.Reserved = 0;
+	USHORT node;
+	if (!GetNumaProcessorNodeEx(&processor, &node) || node == MAXUSHORT) {
+		return -1;
+	}
+	return node;
+}
+
+int pool::set_numa_policy(char*, size_t, numa_policy, int) {
+	// Windows can only choose a node when memory is reserved (VirtualAllocExNuma), and otherwise already places
+	// pages on the node of the thread that first touches them.
+	return -1;
+}
+
 char* pool::reserve_buffer(const size_t size) {
 	void* ret = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
 	if (ret == nullptr) {
@@ -31,13 +69,115 @@ char* pool::reserve_buffer(const size_t size) {
 	return static_cast<char*>(ret);
 }
 
+namespace {
+	// Reserves memory starting on an alignment boundary, since the pool rounds to huge pages.
+	// Windows can't trim a reservation, so find an aligned address in a larger one, release it and reserve there.
+	// Another thread can take the address in between, so try again a few times if that's why it failed.
+	char* reserveAligned(const size_t size, const size_t alignment, const DWORD allocationType) {
+		constexpr int maxAttempts = 16;
+		for (int attempt = 1;; ++attempt) {
+			void* reserved = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+			if (reserved == nullptr) {
+				throw std::system_error(GetLastError(), std::generic_category(),
+					"Failed to allocate memory");
+			}
+			const auto address = (reinterpret_cast<uintptr_t>(reserved) + alignment - 1) & ~(alignment - 1);
+			void* aligned = reinterpret_cast<void*>(address);
+			VirtualFree(reserved, 0, MEM_RELEASE);
+			void* ret = VirtualAlloc(aligned, size, allocationType, PAGE_READWRITE);
+			if (ret != nullptr) {
+				return static_cast<char*>(ret);
+			}
+			// Anything but a lost race, such as MEM_COMMIT hitting the commit limit, won't go away on a retry.
+			const auto error = GetLastError();
+			if (error != ERROR_INVALID_ADDRESS || attempt == maxAttempts) {
+				throw std::system_error(error, std::generic_category(),
+					"Failed to allocate memory");
+			}
+		}
+	}
+}
+
+char* pool::reserve_buffer(const size_t size, const huge_pages hugePages, const commit_mode commitMode) {
+	if (hugePages == huge_pages::Explicit) {
+		// Large pages can't be committed piecemeal, so commit them all now. This needs SeLockMemoryPrivilege.
+		void* ret = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (ret != nullptr) {
+			return static_cast<char*>(ret);
+		}
+	}
+	// Windows can't overcommit, so in Fault mode this charges the whole reservation against the commit limit.
+	// Pages are still only backed by physical memory when first touched.
+	const DWORD allocationType = commitMode == commit_mode::Fault ? MEM_RESERVE | MEM_COMMIT : MEM_RESERVE;
+	if (hugePages == huge_pages::None) {
+		void* ret = VirtualAlloc(nullptr, size, allocationType, PAGE_READWRITE);
+		if (ret == nullptr) {
+			throw std::system_error(GetLastError(), std::generic_category(),
+				"Failed to allocate memory");
+		}
+		return static_cast<char*>(ret);
+	}
+	// Windows has no transparent huge pages, so fall back to base pages. The pool still commits and releases
+	// in huge page steps, so the reservation must start on a huge page boundary like it does on Linux.
+	return reserveAligned(size, get_huge_page_size(), allocationType);
+}
+
+void pool::prefault_pages(char*, size_t) {
+	[[maybe_unused]] metrics::commit_timer timer;
+	// Windows can't populate demand-zero pages without touching them, so let them fault in when first written.
+}
+
+void pool::commit_pages(char* buffer, const size_t size, const commit_mode commitMode) {
+	if (commitMode == commit_mode::Fault) {
+		prefault_pages(buffer, size);
+	} else {
+		allocate_reservation(buffer, size);
+	}
+}
+
 void pool::allocate_reservation(char* buffer, const size_t size) {
+	[[maybe_unused]] metrics::commit_timer timer;
 	if (VirtualAlloc(buffer, size, MEM_COMMIT, PAGE_READWRITE) == 0) {
 		throw std::system_error(errno, std::generic_category(),
 			"Failed to allocate memory");
 	}
 }
 
+void pool::release_pages(char* buffer, const size_t size, const decommit_policy policy) {
+	if (policy == decommit_policy::Free) {
+		if (VirtualAlloc(buffer, size, MEM_RESET, PAGE_READWRITE) == nullptr) {
+			throw std::system_error(GetLastError(), std::generic_category(),
+				"Failed to release memory");
+		}
+		return;
+	}
+	// Decommitting and recommitting drops the pages and leaves zeroed ones in their place, like MADV_DONTNEED.
+	if (VirtualFree(buffer, size, MEM_DECOMMIT) == 0 || VirtualAlloc(buffer, size, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to release memory");
+	}
+}
+
+size_t pool::get_resident_bytes(char* buffer, const size_t size) {
+	const auto pageSize = get_page_size();
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages((size + pageSize - 1) / pageSize);
+	for (size_t i = 0; i < pages.size(); ++i) {
+		pages[i].VirtualAddress = buffer + i * pageSize;
+	}
+	if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(),
+		static_cast<DWORD>(pages.size() * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to query memory");
+	}
+	size_t resident = 0;
+	for (const auto& page : pages) {
+		if (page.VirtualAttributes.Valid) {
+			resident += pageSize;
+		}
+	}
+	return std::min(resident, size);
+}
+
 void pool::free_buffer(char* buffer, const size_t size) {
 	if (VirtualFree(buffer, 0, MEM_RELEASE) == 0) {
 		throw std::system_error(GetLastError(), std::generic_category(),
@@ -45,4 +185,109 @@ void pool::free_buffer(char* buffer, const size_t size) {
 	}
 }
 
+file_pool::mapped_file file_pool::open_file(const std::filesystem::path& path, const size_t size) {
+	HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to open pool file");
+	}
+	mapped_file ret;
+	ret.handle = reinterpret_cast<intptr_t>(handle);
+	LARGE_INTEGER existingSize;
+	if (!GetFileSizeEx(handle, &existingSize)) {
+		const auto error = GetLastError();
+		CloseHandle(handle);
+		throw std::system_error(error, std::generic_category(),
+			"Failed to open pool file");
+	}
+	// An empty file is as good as a new one.
+	ret.created = existingSize.QuadPart == 0;
+	ret.size = ret.created ? size : static_cast<size_t>(existingSize.QuadPart);
+
+	// Mapping more than the file holds extends it.
+	const auto mappingSize = static_cast<uint64_t>(ret.size);
+	HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32),
+		static_cast<DWORD>(mappingSize), nullptr);
+	if (mapping == nullptr) {
+		const auto error = GetLastError();
+		CloseHandle(handle);
+		throw std::system_error(error, std::generic_category(),
+			"Failed to map pool file");
+	}
+	ret.mapping = reinterpret_cast<intptr_t>(mapping);
+	return ret;
+}
+
+file_pool::mapped_file file_pool::open_shared_memory(const std::string& name, const size_t size) {
+	// Windows has no fork, so an anonymous object is shared only by handles duplicated into other processes.
+	const std::wstring wideName(name.begin(), name.end());
+	const auto mappingSize = static_cast<uint64_t>(size);
+	HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize),
+		name.empty() ? nullptr : wideName.c_str());
+	if (mapping == nullptr) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to open shared memory");
+	}
+	mapped_file ret;
+	ret.created = GetLastError() != ERROR_ALREADY_EXISTS;
+	ret.mapping = reinterpret_cast<intptr_t>(mapping);
+	// An existing object keeps its size, which a view of the whole of it reveals.
+	ret.size = size;
+	if (!ret.created) {
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		MEMORY_BASIC_INFORMATION info;
+		if (view == nullptr || VirtualQuery(view, &info, sizeof(info)) == 0) {
+			const auto error = GetLastError();
+			if (view != nullptr) {
+				UnmapViewOfFile(view);
+			}
+			CloseHandle(mapping);
+			throw std::system_error(error, std::generic_category(),
+				"Failed to open shared memory");
+		}
+		ret.size = info.RegionSize;
+		UnmapViewOfFile(view);
+	}
+	return ret;
+}
+
+void file_pool::remove_shared(const std::string&) {
+	// A named file mapping object goes away when its last handle is closed.
+}
+
+void file_pool::map_file(mapped_file& file, void* address) {
+	void* view = MapViewOfFileEx(reinterpret_cast<HANDLE>(file.mapping), FILE_MAP_ALL_ACCESS, 0, 0, file.size,
+		address);
+	if (view == nullptr) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to map pool file");
+	}
+	file.buffer = static_cast<char*>(view);
+}
+
+void file_pool::unmap_file(mapped_file& file) {
+	UnmapViewOfFile(file.buffer);
+	file.buffer = nullptr;
+}
+
+void file_pool::close_file(mapped_file& file) {
+	if (file.buffer != nullptr) {
+		unmap_file(file);
+	}
+	CloseHandle(reinterpret_cast<HANDLE>(file.mapping));
+	if (file.handle != -1) {
+		CloseHandle(reinterpret_cast<HANDLE>(file.handle));
+	}
+}
+
+void file_pool::sync_file(const mapped_file& file, const size_t size) {
+	if (!FlushViewOfFile(file.buffer, size) ||
+		(file.handle != -1 && !FlushFileBuffers(reinterpret_cast<HANDLE>(file.handle)))) {
+		throw std::system_error(GetLastError(), std::generic_category(),
+			"Failed to sync pool file");
+	}
+}
+
 #endif
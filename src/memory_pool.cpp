@@ -1,13 +1,11 @@
 #include "memory-pool/memory_pool.h"
 #include "internal.h"
 #include <stdexcept>
-#include <unordered_map>
 #include <memory>
 #include <string>
 #include <bit>
 #include <cassert>
-#include <sstream>
-#include <iomanip>
+#include <tuple>
 
 using namespace memory_pool;
 
@@ -16,15 +14,65 @@ pool* pool::create(const size_t capacity) {
 }
 
 pool* pool::create(const size_t capacity, const pool_type type) {
+    return create(capacity, type, pool_options());
+}
+
+pool* createPool(const size_t capacity, const pool_type type, const pool_options& options) {
+    if (options.growable) {
+        switch (type) {
+            case pool_type::SingleThreaded:
+                return new growable_pool<simple_pool>(capacity, options);
+            case pool_type::ThreadSafe:
+                return new growable_pool<lock_free_pool>(capacity, options);
+            case pool_type::PerThread:
+                break;
+            default:
+                throw std::invalid_argument("This type of pool cannot grow");
+        }
+    }
     switch (type) {
         case pool_type::SingleThreaded:
-            return new simple_pool(capacity);
+            return new simple_pool(capacity, options);
         case pool_type::PerThread:
-            return new pool_per_thread(capacity);
+            return new pool_per_thread(capacity, options);
+        case pool_type::Locked:
+            return new locked_pool(capacity, options);
+        case pool_type::ThreadBuffered:
+            return new buffered_pool(capacity, options);
+        case pool_type::PerCpu:
+            return new pool_per_cpu(capacity, options);
+        case pool_type::Recycling:
+            return new slab_pool(capacity, options);
         default:
         case pool_type::ThreadSafe:
-            return new locked_pool(capacity);
+            return new lock_free_pool(capacity, options);
+    }
+}
+
+pool* pool::create(const size_t capacity, const pool_type type, const pool_options& options) {
+    auto* ret = createPool(capacity, type, options);
+    ret->runsDestructors = options.runDestructors;
+    return ret;
+}
+
+pool* pool::create(const size_t capacity, const pool_type type, const pool_options& options, void* initialBuffer,
+                   const size_t initialBufferSize) {
+    if (options.growable) {
+        throw std::invalid_argument("A growable pool cannot start with a buffer");
+    }
+    pool* ret;
+    switch (type) {
+        case pool_type::SingleThreaded:
+            ret = new initial_buffer_pool<simple_pool>(capacity, options, initialBuffer, initialBufferSize);
+            break;
+        case pool_type::ThreadSafe:
+            ret = new initial_buffer_pool<lock_free_pool>(capacity, options, initialBuffer, initialBufferSize);
+            break;
+        default:
+            throw std::invalid_argument("This type of pool cannot start with a buffer");
     }
+    ret->runsDestructors = options.runDestructors;
+    return ret;
 }
 
 void* pool::new_buffer(const std::size_t size, const std::size_t alignment) {
@@ -39,14 +87,97 @@ void* pool::do_allocate(const std::size_t size) {
     return do_allocate(size, 1);
 }
 
-void pool::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
-    // Do nothing.
+void pool::new_buffers(const std::size_t count, const std::size_t size, const std::size_t alignment, void** out) {
+    if (count != 0) {
+        do_allocate_bulk(count, size, alignment, out);
+    }
+}
+
+bool pool::try_extend(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    if (newSize < oldSize) {
+        throw std::invalid_argument("try_extend cannot shrink an allocation");
+    }
+    return newSize == oldSize || do_resize(p, oldSize, newSize);
+}
+
+bool pool::shrink(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    if (newSize > oldSize) {
+        throw std::invalid_argument("shrink cannot grow an allocation");
+    }
+    return newSize == oldSize || do_resize(p, oldSize, newSize);
+}
+
+bool pool::do_resize(void*, std::size_t, std::size_t) {
+    return false;
+}
+
+pool_span pool::new_span(const std::size_t size, const std::size_t alignment) {
+    return {do_allocate(size, alignment), size};
+}
+
+pool* pool::create_child(const size_t capacity) {
+    auto* ret = new child_pool(*this, capacity);
+    ret->runsDestructors = runsDestructors;
+    return ret;
+}
+
+void pool::run_destructors(const destructor_entry* until) {
+    auto* entry = lastDestructor.load(std::memory_order_acquire);
+    while (entry != until && entry != nullptr) {
+        auto* previous = entry->previous;
+        entry->destroy(entry);
+        entry = previous;
+    }
+    lastDestructor.store(entry, std::memory_order_relaxed);
+}
+
+pool_marker pool::mark() const {
+    throw std::logic_error("This type of pool does not support markers");
+}
+
+void pool::rewind(const pool_marker&) {
+    throw std::logic_error("This type of pool does not support markers");
+}
+
+pool_statistics pool::get_statistics() const {
+    pool_statistics statistics;
+    statistics.capacity = get_capacity();
+    statistics.size = get_size();
+    statistics.alignmentFragmentation = get_alignment_fragmentation();
+    statistics.committedSize = get_committed_size();
+    statistics.peakSize = get_peak_size();
+    return statistics;
+}
+
+void pool::do_deallocate(void* p, std::size_t bytes, std::size_t) {
+    metrics::record_deallocation();
+    // Only the most recent allocation can be given back, which makes freeing in reverse order work like a stack.
+    (void)do_resize(p, bytes, 0);
 }
 
 bool pool::do_is_equal(const memory_resource& other) const noexcept {
     return this == &other;
 }
 
+size_t pool::get_page_size(const huge_pages hugePages) {
+    return hugePages == huge_pages::None ? get_page_size() : get_huge_page_size();
+}
+
+size_t pool::release_unused_pages(char* firstUnusedByte, char* firstUncommittedByte, const size_t warmReserveBytes,
+                                  const decommit_policy policy, const size_t pageSize) {
+    if (static_cast<size_t>(firstUncommittedByte - firstUnusedByte) <= warmReserveBytes) {
+        return 0;
+    }
+    // Round up so we never release the page holding the last bytes in use.
+    auto* firstReleasedByte = get_containing_page(firstUnusedByte + warmReserveBytes + (pageSize - 1), pageSize);
+    if (firstReleasedByte >= firstUncommittedByte) {
+        return 0;
+    }
+    const size_t toRelease = firstUncommittedByte - firstReleasedByte;
+    release_pages(firstReleasedByte, toRelease, policy);
+    return toRelease;
+}
+
 size_t roundUpToPowerOf2(const size_t n) {
     if (n == 0)
         return 1;
@@ -55,6 +186,23 @@ size_t roundUpToPowerOf2(const size_t n) {
     return static_cast<size_t>(1) << (64 - std::countl_zero(n));
 }
 
+size_t roundUpToMultiple(const size_t n, const size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+void pool::do_allocate_bulk(const std::size_t count, const std::size_t size, const std::size_t alignment,
+                            void** out) {
+    // Every buffer after the first is aligned if the stride is a multiple of the alignment.
+    const auto stride = roundUpToMultiple(size, alignment);
+    if (stride != 0 && count > SIZE_MAX / stride) {
+        throw std::bad_array_new_length();
+    }
+    auto* buffer = static_cast<char*>(do_allocate(count * stride, alignment));
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = buffer + i * stride;
+    }
+}
+
 size_t computeCommitAheadBytes(size_t pageSize) {
     constexpr auto oneMegabyte = static_cast<size_t>(1 << 20);
     if (pageSize < oneMegabyte) {
@@ -63,44 +211,144 @@ size_t computeCommitAheadBytes(size_t pageSize) {
     return roundUpToPowerOf2(pageSize);
 }
 
-simple_pool::simple_pool(const size_t capacity)
-    : totalCapacity(capacity),
-      commitAheadBytes(computeCommitAheadBytes(get_page_size())) {
-    buffer = reserve_buffer(capacity);
-    firstCommittedUnusedByte = buffer;
-    const auto initialCommit = std::min(capacity, commitAheadBytes);
-    allocate_reservation(firstCommittedUnusedByte, initialCommit);
-    firstUncommittedByte = buffer + initialCommit;
+size_t computeCommitAheadBytes(const size_t pageSize, const pool_options& options) {
+    if (options.commitMode == commit_mode::Fault && options.prefaultBytes != 0) {
+        return roundUpToPowerOf2(std::max(options.prefaultBytes, pageSize));
+    }
+    return computeCommitAheadBytes(pageSize);
+}
+
+// Gets how much of a new reservation to commit up front, or nothing if it needs no committing.
+size_t computeInitialCommit(const size_t reservedBytes, const size_t commitAheadBytes, const pool_options& options) {
+    if (options.commitMode == commit_mode::Fault && options.prefaultBytes == 0 && options.backgroundCommitBytes == 0) {
+        return 0;
+    }
+    return std::min(reservedBytes, commitAheadBytes);
 }
 
-simple_pool::~simple_pool() {
-    free_buffer(buffer, totalCapacity);
+template<typename ThreadingPolicy>
+configured_pool<ThreadingPolicy>::configured_pool(const size_t capacity, const pool_options& options,
+                                                  const int preferredNode)
+    : configured_pool(capacity, options, reserve(capacity, options, preferredNode)) {
 }
 
-size_t simple_pool::get_alignment_fragmentation() const {
-    return alignmentFragmentationBytes;
+template<typename ThreadingPolicy>
+configured_pool<ThreadingPolicy>::configured_pool(const size_t capacity, const pool_options& options,
+                                                  const reservation& reserved)
+    : base(capacity, reserved.reservedBytes, reserved.buffer, reserved.committedBytes,
+           configured_commit{options.commitMode,
+                             computeCommitAheadBytes(pool::get_page_size(options.hugePages), options),
+                             options.backgroundCommitBytes,
+                             this}),
+      pageSize(pool::get_page_size(options.hugePages)),
+      hugePages(options.hugePages),
+      numaPolicy(options.numaPolicy),
+      decommitPolicy(options.decommitPolicy),
+      warmReserveBytes(options.warmReserveBytes),
+      trimOnRewind(options.trimOnRewind),
+      numaNode(reserved.numaNode) {
+    if (options.backgroundCommitBytes != 0) {
+        background_committer::instance().add(this);
+    }
 }
 
-void simple_pool::printStats() {
-    std::stringstream ss;
-    ss << std::hex;
-    ss << "Pool " << reinterpret_cast<uintptr_t>(this) << ":\n";
-    ss << "  Uncommitted reserved: " << (buffer + totalCapacity) - firstUncommittedByte << '\n';
-    ss << "  Committed unused: " << firstUncommittedByte - firstCommittedUnusedByte << '\n';
-    ss << "  Used: " << firstCommittedUnusedByte - buffer << '\n';
-    printf("%s\n", ss.str().c_str());
-    fflush(stdout);
+template<typename ThreadingPolicy>
+typename configured_pool<ThreadingPolicy>::reservation configured_pool<ThreadingPolicy>::reserve(
+    const size_t capacity, const pool_options& options, const int preferredNode) {
+    const auto pageSize = pool::get_page_size(options.hugePages);
+    reservation ret{nullptr, roundUpToMultiple(capacity, pageSize), 0, -1};
+    ret.buffer = pool::take_reservation(ret.reservedBytes, options.hugePages, options.commitMode, options.numaPolicy,
+                                        ret.committedBytes);
+    ret.numaNode = pool::set_numa_policy(ret.buffer, ret.reservedBytes, options.numaPolicy, preferredNode);
+    const auto initialCommit = computeInitialCommit(ret.reservedBytes, computeCommitAheadBytes(pageSize, options),
+                                                    options);
+    if (initialCommit == 0) {
+        ret.committedBytes = ret.reservedBytes;
+    } else if (ret.committedBytes < initialCommit) {
+        // Otherwise, the reservation's last pool committed enough.
+        pool::commit_pages(ret.buffer + ret.committedBytes, initialCommit - ret.committedBytes, options.commitMode);
+        ret.committedBytes = initialCommit;
+    }
+    return ret;
 }
 
-size_t simple_pool::get_size() const {
-    return bytesInUse;
+template<typename ThreadingPolicy>
+configured_pool<ThreadingPolicy>::~configured_pool() {
+    this->run_destructors();
+    if (this->commitPolicy.backgroundCommitBytes != 0) {
+        background_committer::instance().remove(this);
+    }
+    pool::give_back_reservation(this->buffer, this->reservedBytes, hugePages, this->commitPolicy.commitMode,
+                                numaPolicy, this->get_committed_size());
 }
 
-size_t simple_pool::get_capacity() const {
-    return totalCapacity;
+template<typename ThreadingPolicy>
+int configured_pool<ThreadingPolicy>::get_numa_node() const {
+    return numaNode;
+}
+
+template<typename ThreadingPolicy>
+size_t configured_pool<ThreadingPolicy>::trim() {
+    std::lock_guard lock(this->commitMutex);
+    return pool::release_unused_pages(this->buffer + this->bytesInUse.load(),
+                                      this->firstUncommittedByte.load(std::memory_order_relaxed),
+                                      warmReserveBytes,
+                                      decommitPolicy,
+                                      pageSize);
+}
+
+template<typename ThreadingPolicy>
+void configured_pool<ThreadingPolicy>::rewind(const pool_marker& marker) {
+    base::rewind(marker);
+    if (trimOnRewind) {
+        (void)trim();
+    }
+}
+
+template<typename ThreadingPolicy>
+void* configured_pool<ThreadingPolicy>::do_allocate(const std::size_t bytes, const std::size_t alignment) {
+    metrics::record_allocation(bytes, alignment);
+    return base::do_allocate(bytes, alignment);
+}
+
+template<typename ThreadingPolicy>
+void configured_pool<ThreadingPolicy>::commit_in_background() {
+    std::lock_guard lock(this->commitMutex);
+    auto* uncommitted = this->firstUncommittedByte.load(std::memory_order_relaxed);
+    const auto& commitPolicy = this->commitPolicy;
+    const auto wantedBytes = std::min(this->reservedBytes,
+                                      roundUpToMultiple(this->bytesInUse.load() + commitPolicy.backgroundCommitBytes,
+                                                        commitPolicy.chunkBytes));
+    if (this->buffer + wantedBytes <= uncommitted) {
+        return;
+    }
+    const size_t toCommit = (this->buffer + wantedBytes) - uncommitted;
+    pool::commit_pages(uncommitted, toCommit, commitPolicy.commitMode);
+    if (commitPolicy.commitMode == commit_mode::Protect) {
+        // Take the first-touch faults here too, not just the mprotect.
+        pool::prefault_pages(uncommitted, toCommit);
+    }
+    this->firstUncommittedByte.store(uncommitted + toCommit, std::memory_order_release);
+}
+
+template class configured_pool<single_allocator>;
+template class configured_pool<thread_safe>;
+
+bool configured_commit::request_commit() const {
+    if (backgroundCommitBytes == 0) {
+        return false;
+    }
+    background_committer::instance().request(target);
+    return true;
+}
+
+void checkMarker(const pool_marker& marker, const size_t bytesInUse) {
+    if (marker.position > bytesInUse) {
+        throw std::invalid_argument("Marker is past the pool's current position");
+    }
 }
 
-[[nodiscard]] size_t computeAlignmentSkip(const char* pointer, const size_t alignment) {
+size_t computeAlignmentSkip(const char* pointer, const size_t alignment) {
     size_t remainder;
     if ((alignment & (alignment - 1)) == 0) {
         // Alignment is a power of 2.
@@ -113,68 +361,39 @@ size_t simple_pool::get_capacity() const {
     return alignment - remainder;
 }
 
-void* simple_pool::do_allocate(std::size_t size, std::size_t alignment) {
-    if (totalCapacity - bytesInUse < size) [[unlikely]] {
-        std::string message = "Out of memory: ";
+[[noreturn]] void throwOutOfMemory(const size_t size, const size_t alignment, const size_t freeBytes) {
+    std::string message = "Out of memory: ";
+    if (freeBytes < size) {
         message += std::to_string(size) + " bytes requested, but pool has ";
-        message += std::to_string(totalCapacity - bytesInUse);
+        message += std::to_string(freeBytes);
         message += " bytes free";
-        throw std::invalid_argument(message);
-    }
-
-    const auto alignmentSkip = computeAlignmentSkip(firstCommittedUnusedByte, alignment);
-
-    const size_t toCommitAhead = (alignmentSkip + size * 2 + (commitAheadBytes - 1)) & ~(commitAheadBytes - 1);
-
-    if (firstCommittedUnusedByte + toCommitAhead > firstUncommittedByte) {
-        size_t toCommit;
-        if (firstUncommittedByte - buffer + toCommitAhead > totalCapacity) {
-            toCommit = (buffer + totalCapacity) - firstUncommittedByte;
-        } else {
-            toCommit = toCommitAhead;
-        }
-        if (toCommit > 0) {
-            auto* firstUncommittedPage = get_containing_page(firstUncommittedByte);
-            const auto pointInPage = firstUncommittedByte - firstUncommittedPage;
-            allocate_reservation(firstUncommittedPage, toCommit);
-            firstUncommittedByte += toCommit;
-        }
-    }
-
-    void* ret = alignmentSkip + firstCommittedUnusedByte;
-    auto* newFirstCommittedUnusedByte = firstCommittedUnusedByte + alignmentSkip + size;
-    if (newFirstCommittedUnusedByte > buffer + totalCapacity) {
-        std::string message = "Out of memory: ";
+    } else {
         message += std::to_string(size) + " bytes requested with ";
         message += std::to_string(alignment) + "-byte alignment, which pool cannot fit in its last ";
-        message += std::to_string(totalCapacity - bytesInUse);
+        message += std::to_string(freeBytes);
         message += " free bytes";
-        throw std::invalid_argument(message);
-    }
-
-    firstCommittedUnusedByte = newFirstCommittedUnusedByte;
-    bytesInUse += alignmentSkip + size;
-    alignmentFragmentationBytes += alignmentSkip;
-
-    if (bytesInUse == totalCapacity) {
-        assert(firstUncommittedByte == buffer + totalCapacity);
-        assert(firstCommittedUnusedByte == buffer + totalCapacity);
-    } else {
-        assert(firstCommittedUnusedByte < firstUncommittedByte);
     }
+    throw std::invalid_argument(message);
+}
 
-    return ret;
+void pool::throw_out_of_memory(const size_t size, const size_t alignment, const size_t freeBytes) {
+    throwOutOfMemory(size, alignment, freeBytes);
 }
 
-locked_pool::locked_pool(const size_t capacity)
-    : pool(capacity) {
+locked_pool::locked_pool(const size_t capacity, const pool_options& options)
+    : pool(capacity, options) {
 }
 
 void* locked_pool::do_allocate(std::size_t size, std::size_t alignment) {
-    std::lock_guard lock(mutex);
+    const auto lock = metrics::lock(mutex);
     return pool.do_allocate(size, alignment);
 }
 
+bool locked_pool::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    const auto lock = metrics::lock(mutex);
+    return pool.do_resize(p, oldSize, newSize);
+}
+
 size_t locked_pool::get_alignment_fragmentation() const {
     std::lock_guard lock(mutex);
     return pool.get_alignment_fragmentation();
@@ -189,38 +408,899 @@ size_t locked_pool::get_size() const {
     return pool.get_size();
 }
 
-pool_per_thread::pool_per_thread(const size_t capacity)
-    : totalCapacity(capacity) {
+size_t locked_pool::get_committed_size() const {
+    std::lock_guard lock(mutex);
+    return pool.get_committed_size();
+}
+
+size_t locked_pool::get_resident_size() const {
+    std::lock_guard lock(mutex);
+    return pool.get_resident_size();
+}
+
+int locked_pool::get_numa_node() const {
+    return pool.get_numa_node();
+}
+
+size_t locked_pool::get_peak_size() const {
+    return pool.get_peak_size();
+}
+
+size_t locked_pool::trim() {
+    std::lock_guard lock(mutex);
+    return pool.trim();
+}
+
+locked_pool::~locked_pool() {
+    run_destructors();
+}
+
+void locked_pool::reset() {
+    std::lock_guard lock(mutex);
+    run_destructors();
+    pool.reset();
+}
+
+pool_marker locked_pool::mark() const {
+    std::lock_guard lock(mutex);
+    auto marker = pool.mark();
+    marker.lastDestructor = get_last_destructor();
+    return marker;
+}
+
+void locked_pool::rewind(const pool_marker& marker) {
+    std::lock_guard lock(mutex);
+    if (marker.position <= pool.get_size()) {
+        run_destructors(marker.lastDestructor);
+    }
+    pool.rewind(marker);
+}
+
+buffered_pool::buffered_pool(const size_t capacity, const pool_options& options)
+    : shared(capacity, options),
+      threadBufferSize(options.threadBufferSize),
+      buffers([this](thread_entry& entry) {
+          // Leave the rest of the exiting thread's buffer for the next new thread.
+          const auto& buffer = static_cast<thread_buffer&>(entry);
+          exitedAlignmentFragmentationBytes.fetch_add(
+              buffer.alignmentFragmentationBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          if (buffer.cursor != buffer.end) {
+              std::lock_guard lock(leftoversMutex);
+              leftovers.emplace_back(buffer.cursor, buffer.end);
+              leftoverBytes.fetch_add(buffer.end - buffer.cursor, std::memory_order_release);
+          }
+      }) {
+    if (threadBufferSize == 0) {
+        throw std::invalid_argument("Thread buffer size must be positive");
+    }
+}
+
+size_t buffered_pool::get_capacity() const {
+    return shared.get_capacity();
+}
+
+size_t buffered_pool::get_size() const {
+    // Buffers are taken from the shared pool before their unused bytes are published, so reading the shared size
+    // after acquiring those makes it cover them.
+    size_t unusedBytes = leftoverBytes.load(std::memory_order_acquire);
+    buffers.for_each([&](const thread_entry& entry) {
+        unusedBytes += static_cast<const thread_buffer&>(entry).unusedBytes.load(std::memory_order_acquire);
+    });
+    const auto sharedBytes = shared.get_size();
+    // A leftover buffer moving to a new thread while we count can be counted twice.
+    return sharedBytes > unusedBytes ? sharedBytes - unusedBytes : 0;
+}
+
+size_t buffered_pool::get_alignment_fragmentation() const {
+    auto fragmentation = shared.get_alignment_fragmentation() +
+                         exitedAlignmentFragmentationBytes.load(std::memory_order_relaxed);
+    buffers.for_each([&](const thread_entry& entry) {
+        fragmentation += static_cast<const thread_buffer&>(entry).alignmentFragmentationBytes.load(
+            std::memory_order_relaxed);
+    });
+    return fragmentation;
+}
+
+size_t buffered_pool::get_committed_size() const {
+    return shared.get_committed_size();
+}
+
+size_t buffered_pool::get_resident_size() const {
+    return shared.get_resident_size();
+}
+
+int buffered_pool::get_numa_node() const {
+    return shared.get_numa_node();
+}
+
+size_t buffered_pool::get_peak_size() const {
+    return shared.get_peak_size();
+}
+
+size_t buffered_pool::trim() {
+    return shared.trim();
+}
+
+buffered_pool::~buffered_pool() {
+    run_destructors();
+}
+
+void buffered_pool::reset() {
+    run_destructors();
+    buffers.for_each([](thread_entry& entry) {
+        auto& buffer = static_cast<thread_buffer&>(entry);
+        buffer.cursor = nullptr;
+        buffer.end = nullptr;
+        buffer.unusedBytes.store(0, std::memory_order_relaxed);
+        buffer.alignmentFragmentationBytes.store(0, std::memory_order_relaxed);
+    });
+    {
+        std::lock_guard lock(leftoversMutex);
+        leftovers.clear();
+    }
+    leftoverBytes.store(0, std::memory_order_relaxed);
+    exitedAlignmentFragmentationBytes.store(0, std::memory_order_relaxed);
+    shared.reset();
+}
+
+void* buffered_pool::do_allocate(std::size_t size, std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    return allocate_from_buffer(size, alignment);
+}
+
+void* buffered_pool::allocate_from_buffer(std::size_t size, std::size_t alignment) {
+    auto* buffer = get_thread_buffer();
+    const auto alignmentSkip = computeAlignmentSkip(buffer->cursor, alignment);
+    if (static_cast<size_t>(buffer->end - buffer->cursor) < alignmentSkip + size) [[unlikely]] {
+        return refill_and_allocate(buffer, size, alignment);
+    }
+    void* ret = buffer->cursor + alignmentSkip;
+    buffer->cursor += alignmentSkip + size;
+    buffer->unusedBytes.store(buffer->end - buffer->cursor, std::memory_order_release);
+    if (alignmentSkip != 0) {
+        buffer->alignmentFragmentationBytes.store(
+            buffer->alignmentFragmentationBytes.load(std::memory_order_relaxed) + alignmentSkip,
+            std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+void* buffered_pool::refill_and_allocate(thread_buffer* buffer, const std::size_t size, const std::size_t alignment) {
+    const auto worstCase = size + alignment - 1;
+    const auto available = shared.get_capacity() - shared.get_size();
+    const auto refillSize = std::min(threadBufferSize, available);
+    if (worstCase > threadBufferSize / 2 || worstCase > refillSize) {
+        // Too big to be worth buffering, or the pool is nearly full: take it straight from the shared pool.
+        return take_from_shared(size, alignment);
+    }
+    buffer->cursor = static_cast<char*>(take_from_shared(refillSize, 1));
+    buffer->end = buffer->cursor + refillSize;
+    buffer->unusedBytes.store(refillSize, std::memory_order_release);
+    return allocate_from_buffer(size, alignment);
+}
+
+void* buffered_pool::take_from_shared(const std::size_t size, const std::size_t alignment) {
+    auto* ret = shared.try_allocate(size, alignment);
+    if (ret == nullptr) [[unlikely]] {
+        throwOutOfMemory(size, alignment, shared.get_capacity() - shared.get_size());
+    }
+    return ret;
+}
+
+buffered_pool::thread_buffer* buffered_pool::get_thread_buffer() {
+    if (auto* entry = buffers.find()) [[likely]] {
+        return static_cast<thread_buffer*>(entry);
+    }
+    auto buffer = std::make_unique<thread_buffer>();
+    {
+        std::lock_guard lock(leftoversMutex);
+        if (!leftovers.empty()) {
+            std::tie(buffer->cursor, buffer->end) = leftovers.back();
+            leftovers.pop_back();
+            buffer->unusedBytes.store(buffer->end - buffer->cursor, std::memory_order_release);
+            leftoverBytes.fetch_sub(buffer->end - buffer->cursor, std::memory_order_relaxed);
+        }
+    }
+    return static_cast<thread_buffer*>(buffers.add(std::move(buffer)));
+}
+
+pool_per_cpu::shard::shard(const size_t capacity, const pool_options& options, const int numaNode)
+    : pool(capacity, options, numaNode) {
+}
+
+pool_per_cpu::pool_per_cpu(const size_t capacity, const pool_options& options) {
+    auto shardCount = options.cpuShardCount == 0 ? get_cpu_count() : options.cpuShardCount;
+    // Every shard needs at least one byte.
+    shardCount = std::max<size_t>(1, std::min(shardCount, capacity));
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        // Spread the remainder over the first shards so the capacities add up exactly.
+        const auto shardCapacity = capacity / shardCount + (i < capacity % shardCount ? 1 : 0);
+        // Shard i serves CPU i first, so place it on that CPU's node.
+        shards.push_back(std::make_unique<shard>(shardCapacity, options, get_cpu_numa_node(i)));
+    }
+}
+
+int pool_per_cpu::get_numa_node() const {
+    return shards[get_current_cpu() % shards.size()]->pool.get_numa_node();
+}
+
+size_t pool_per_cpu::get_peak_size() const {
+    size_t peak = 0;
+    for (const auto& shard : shards) {
+        peak += shard->pool.get_peak_size();
+    }
+    return peak;
+}
+
+size_t pool_per_cpu::get_capacity() const {
+    size_t capacity = 0;
+    for (const auto& shard : shards) {
+        capacity += shard->pool.get_capacity();
+    }
+    return capacity;
+}
+
+size_t pool_per_cpu::get_size() const {
+    size_t size = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        size += shard->pool.get_size();
+    }
+    return size;
+}
+
+size_t pool_per_cpu::get_alignment_fragmentation() const {
+    size_t fragmentation = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        fragmentation += shard->pool.get_alignment_fragmentation();
+    }
+    return fragmentation;
+}
+
+size_t pool_per_cpu::get_committed_size() const {
+    size_t committed = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        committed += shard->pool.get_committed_size();
+    }
+    return committed;
+}
+
+size_t pool_per_cpu::get_resident_size() const {
+    size_t resident = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        resident += shard->pool.get_resident_size();
+    }
+    return resident;
+}
+
+size_t pool_per_cpu::trim() {
+    size_t released = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        released += shard->pool.trim();
+    }
+    return released;
+}
+
+pool_per_cpu::~pool_per_cpu() {
+    run_destructors();
+}
+
+void pool_per_cpu::reset() {
+    run_destructors();
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        shard->pool.reset();
+    }
+}
+
+void* pool_per_cpu::do_allocate(std::size_t size, std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    // If our CPU's shard is busy, we were probably migrated or preempted while another thread took it.
+    // Looking up the CPU again is cheap and usually lands on an idle shard, so do that a few times before waiting.
+    constexpr int retries = 4;
+    for (int attempt = 0;; ++attempt) {
+        auto& shard = *shards[get_current_cpu() % shards.size()];
+        std::unique_lock lock(shard.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            if (attempt < retries) {
+                continue;
+            }
+            lock.lock();
+        }
+        if (auto* ret = shard.pool.try_allocate(size, alignment)) [[likely]] {
+            return ret;
+        }
+        break;
+    }
+
+    // This CPU's shard is full. Fall back to any shard that still has room.
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        if (auto* ret = shard->pool.try_allocate(size, alignment)) {
+            return ret;
+        }
+    }
+    throwOutOfMemory(size, alignment, get_capacity() - get_size());
+}
+
+pool_per_thread::pool_per_thread(const size_t capacity, const pool_options& options)
+    : totalCapacity(capacity),
+      options(options) {
 }
 
 
 size_t pool_per_thread::get_capacity() const {
-    return get_thread_local_pool()->get_capacity();
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? totalCapacity : threadPool->get_capacity();
 }
 
 size_t pool_per_thread::get_size() const {
-    return get_thread_local_pool()->get_size();
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? 0 : threadPool->get_size();
 }
 
 size_t pool_per_thread::get_alignment_fragmentation() const {
-    return get_thread_local_pool()->get_alignment_fragmentation();
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? 0 : threadPool->get_alignment_fragmentation();
+}
+
+size_t pool_per_thread::get_committed_size() const {
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? 0 : threadPool->get_committed_size();
+}
+
+size_t pool_per_thread::get_resident_size() const {
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? 0 : threadPool->get_resident_size();
+}
+
+int pool_per_thread::get_numa_node() const {
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? -1 : threadPool->get_numa_node();
+}
+
+size_t pool_per_thread::get_peak_size() const {
+    const auto* threadPool = find_thread_local_pool();
+    return threadPool == nullptr ? 0 : threadPool->get_peak_size();
+}
+
+pool_statistics pool_per_thread::get_statistics() const {
+    pool_statistics statistics;
+    threadPools.for_each_unlocked([&](const thread_entry& entry) {
+        const auto& threadPool = static_cast<const thread_pool&>(entry);
+        thread_usage usage;
+        usage.threadId = threadPool.threadId;
+        usage.capacity = threadPool.threadPool->get_capacity();
+        usage.size = threadPool.threadPool->get_size();
+        usage.alignmentFragmentation = threadPool.threadPool->get_alignment_fragmentation();
+        usage.committedSize = threadPool.threadPool->get_committed_size();
+        usage.peakSize = threadPool.threadPool->get_peak_size();
+        statistics.capacity += usage.capacity;
+        statistics.size += usage.size;
+        statistics.alignmentFragmentation += usage.alignmentFragmentation;
+        statistics.committedSize += usage.committedSize;
+        statistics.peakSize += usage.peakSize;
+        statistics.threads.push_back(usage);
+    });
+    return statistics;
+}
+
+size_t pool_per_thread::trim() {
+    return get_thread_local_pool()->trim();
+}
+
+void pool_per_thread::reset() {
+    get_thread_local_pool()->reset();
+}
+
+pool_marker pool_per_thread::mark() const {
+    return get_thread_local_pool()->mark();
+}
+
+void pool_per_thread::rewind(const pool_marker& marker) {
+    get_thread_local_pool()->rewind(marker);
+}
+
+pool& pool_per_thread::get_destructor_owner() {
+    return *get_thread_local_pool();
 }
 
 void* pool_per_thread::do_allocate(std::size_t size, std::size_t alignment) {
     return get_thread_local_pool()->allocate(size, alignment);
 }
 
+bool pool_per_thread::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    // A thread without a pool has no allocation to resize, so don't make it one.
+    auto* threadPool = const_cast<pool*>(find_thread_local_pool());
+    if (threadPool == nullptr) {
+        return false;
+    }
+    return newSize > oldSize ? threadPool->try_extend(p, oldSize, newSize) : threadPool->shrink(p, oldSize, newSize);
+}
+
+const pool* pool_per_thread::find_thread_local_pool() const {
+    const auto* entry = threadPools.find();
+    return entry == nullptr ? nullptr : static_cast<const thread_pool*>(entry)->threadPool.get();
+}
+
 pool* pool_per_thread::get_thread_local_pool() const {
-    static thread_local std::unordered_map<const pool_per_thread*, std::unique_ptr<pool>> threadLocalPools;
-    const auto it = threadLocalPools.find(this);
-    if (it != threadLocalPools.end()) {
-        return it->second.get();
+    if (auto* entry = threadPools.find()) [[likely]] {
+        return static_cast<thread_pool*>(entry)->threadPool.get();
     }
-    auto* ret = create_pool();
-    threadLocalPools[this] = std::unique_ptr<pool>(ret);
-    return ret;
+    auto entry = std::make_unique<thread_pool>();
+    entry->threadPool.reset(create_pool());
+    return static_cast<thread_pool*>(threadPools.add(std::move(entry)))->threadPool.get();
 }
 
 pool* pool_per_thread::create_pool() const {
-    return new simple_pool(totalCapacity);
+    if (options.growable) {
+        return new growable_pool<simple_pool>(totalCapacity, options);
+    }
+    return new simple_pool(totalCapacity, options);
+}
+
+template<typename Segment>
+growable_pool<Segment>::growable_pool(const size_t capacity, const pool_options& options)
+    : options(options),
+      maxCapacity(options.maxCapacity) {
+    if (maxCapacity != 0 && maxCapacity < capacity) {
+        throw std::invalid_argument("Maximum capacity must not be less than the capacity");
+    }
+    segments.push_back(std::make_unique<Segment>(capacity, options));
+    current = segments.back().get();
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_capacity() const {
+    return sum([](const Segment& segment) { return segment.get_capacity(); });
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_size() const {
+    return sum([](const Segment& segment) { return segment.get_size(); });
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_alignment_fragmentation() const {
+    return sum([](const Segment& segment) { return segment.get_alignment_fragmentation(); });
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_committed_size() const {
+    return sum([](const Segment& segment) { return segment.get_committed_size(); });
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_resident_size() const {
+    return sum([](const Segment& segment) { return segment.get_resident_size(); });
+}
+
+template<typename Segment>
+int growable_pool<Segment>::get_numa_node() const {
+    return current.load(std::memory_order_acquire)->get_numa_node();
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::get_peak_size() const {
+    std::lock_guard lock(segmentsMutex);
+    size_t peak = 0;
+    for (const auto& segment : segments) {
+        peak += segment->get_peak_size();
+    }
+    return std::max(peakBytesBeforeRewind, peak);
+}
+
+template<typename Segment>
+size_t growable_pool<Segment>::trim() {
+    std::lock_guard lock(segmentsMutex);
+    size_t trimmed = 0;
+    for (const auto& segment : segments) {
+        trimmed += segment->trim();
+    }
+    return trimmed;
+}
+
+template<typename Segment>
+growable_pool<Segment>::~growable_pool() {
+    run_destructors();
+}
+
+template<typename Segment>
+void growable_pool<Segment>::reset() {
+    rewind(pool_marker{});
+}
+
+template<typename Segment>
+pool_marker growable_pool<Segment>::mark() const {
+    std::lock_guard lock(segmentsMutex);
+    size_t base = 0;
+    size_t fragmentation = 0;
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        base += segments[i]->get_capacity();
+        fragmentation += segments[i]->get_alignment_fragmentation();
+    }
+    const auto marker = segments.back()->mark();
+    return {base + marker.position, fragmentation + marker.alignmentFragmentation, get_last_destructor()};
+}
+
+template<typename Segment>
+void growable_pool<Segment>::rewind(const pool_marker& marker) {
+    std::lock_guard lock(segmentsMutex);
+    // Find the segment the marker points into.
+    size_t base = 0;
+    size_t fragmentation = 0;
+    size_t index = 0;
+    while (index + 1 < segments.size() && base + segments[index]->get_capacity() <= marker.position) {
+        base += segments[index]->get_capacity();
+        fragmentation += segments[index]->get_alignment_fragmentation();
+        ++index;
+    }
+    if (marker.position - base <= segments[index]->get_size()) {
+        run_destructors(marker.lastDestructor);
+    }
+    size_t peak = 0;
+    for (const auto& segment : segments) {
+        peak += segment->get_peak_size();
+    }
+    segments[index]->rewind({marker.position - base, marker.alignmentFragmentation - fragmentation});
+    peakBytesBeforeRewind = std::max(peakBytesBeforeRewind, peak);
+    segments.resize(index + 1);
+    current.store(segments.back().get(), std::memory_order_release);
+}
+
+template<typename Segment>
+void* growable_pool<Segment>::do_allocate(std::size_t size, std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    auto* segment = current.load(std::memory_order_acquire);
+    if (auto* ret = segment->try_allocate(size, alignment)) [[likely]] {
+        return ret;
+    }
+    return grow_and_allocate(segment, size, alignment);
+}
+
+template<typename Segment>
+bool growable_pool<Segment>::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    // An allocation in an earlier segment isn't the most recent, and the current segment knows it isn't one of its.
+    return current.load(std::memory_order_acquire)->do_resize(p, oldSize, newSize);
+}
+
+template<typename Segment>
+void* growable_pool<Segment>::grow_and_allocate(Segment* full, std::size_t size, std::size_t alignment) {
+    std::lock_guard lock(segmentsMutex);
+    auto* last = segments.back().get();
+    if (last != full) {
+        // Another thread grew the pool while we waited.
+        if (auto* ret = last->try_allocate(size, alignment)) {
+            return ret;
+        }
+    }
+    size_t totalCapacity = 0;
+    for (const auto& segment : segments) {
+        totalCapacity += segment->get_capacity();
+    }
+    // A new segment is page-aligned, so this is enough for any alignment.
+    const auto worstCase = size + alignment - 1;
+    auto capacity = std::max(last->get_capacity() * 2, worstCase);
+    if (maxCapacity != 0) {
+        const auto headroom = maxCapacity - totalCapacity;
+        if (headroom < worstCase) {
+            throwOutOfMemory(size, alignment, headroom + last->get_capacity() - last->get_size());
+        }
+        capacity = std::min(capacity, headroom);
+    }
+    segments.push_back(std::make_unique<Segment>(capacity, options));
+    auto* ret = segments.back()->try_allocate(size, alignment);
+    current.store(segments.back().get(), std::memory_order_release);
+    return ret;
+}
+
+template class growable_pool<simple_pool>;
+template class growable_pool<lock_free_pool>;
+
+template<typename Backing>
+initial_buffer_pool<Backing>::initial_buffer_pool(const size_t capacity, const pool_options& options,
+                                                  void* initialBuffer, const size_t initialBufferSize)
+    : totalCapacity(capacity),
+      options(options),
+      initial(initialBuffer, std::min(initialBufferSize, capacity)) {
+}
+
+template<typename Backing>
+initial_buffer_pool<Backing>::~initial_buffer_pool() {
+    run_destructors();
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_capacity() const {
+    return totalCapacity;
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_size() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    return initial.get_size() + (backingPool != nullptr ? backingPool->get_size() : 0);
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_alignment_fragmentation() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    return initial.get_alignment_fragmentation() +
+           (backingPool != nullptr ? backingPool->get_alignment_fragmentation() : 0);
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_committed_size() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    return initial.get_capacity() + (backingPool != nullptr ? backingPool->get_committed_size() : 0);
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_resident_size() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    return backingPool != nullptr ? backingPool->get_resident_size() : 0;
+}
+
+template<typename Backing>
+int initial_buffer_pool<Backing>::get_numa_node() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    return backingPool != nullptr ? backingPool->get_numa_node() : -1;
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::get_peak_size() const {
+    return std::max(peakBytesBeforeRewind.load(), get_size());
+}
+
+template<typename Backing>
+size_t initial_buffer_pool<Backing>::trim() {
+    auto* backingPool = backing.load(std::memory_order_acquire);
+    return backingPool != nullptr ? backingPool->trim() : 0;
+}
+
+template<typename Backing>
+void initial_buffer_pool<Backing>::reset() {
+    rewind(pool_marker{});
+}
+
+template<typename Backing>
+pool_marker initial_buffer_pool<Backing>::mark() const {
+    const auto* backingPool = backing.load(std::memory_order_acquire);
+    if (!initialBufferClosed.load(std::memory_order_acquire) || backingPool == nullptr) {
+        return {initial.get_size(), initial.get_alignment_fragmentation(), get_last_destructor()};
+    }
+    const auto marker = backingPool->mark();
+    return {initial.get_capacity() + marker.position,
+            initial.get_alignment_fragmentation() + marker.alignmentFragmentation,
+            get_last_destructor()};
+}
+
+template<typename Backing>
+void initial_buffer_pool<Backing>::rewind(const pool_marker& marker) {
+    auto* backingPool = backing.load(std::memory_order_acquire);
+    const auto closed = initialBufferClosed.load(std::memory_order_acquire) && backingPool != nullptr;
+    if (closed && marker.position >= initial.get_capacity()) {
+        // The marker points into the backing pool.
+        const auto backingPosition = marker.position - initial.get_capacity();
+        checkMarker({backingPosition, 0}, backingPool->get_size());
+        run_destructors(marker.lastDestructor);
+        peakBytesBeforeRewind.store(get_peak_size());
+        backingPool->rewind({backingPosition,
+                             marker.alignmentFragmentation - initial.get_alignment_fragmentation()});
+        return;
+    }
+    checkMarker(marker, initial.get_size());
+    run_destructors(marker.lastDestructor);
+    peakBytesBeforeRewind.store(get_peak_size());
+    if (backingPool != nullptr) {
+        backingPool->reset();
+    }
+    initial.rewind({marker.position, marker.alignmentFragmentation});
+    initialBufferClosed.store(false, std::memory_order_release);
+}
+
+template<typename Backing>
+void* initial_buffer_pool<Backing>::do_allocate(std::size_t size, std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    if (!initialBufferClosed.load(std::memory_order_acquire)) [[likely]] {
+        if (auto* ret = initial.try_allocate(size, alignment)) [[likely]] {
+            return ret;
+        }
+    }
+    auto* backingPool = get_or_create_backing();
+    void* ret = backingPool != nullptr ? backingPool->try_allocate(size, alignment) : nullptr;
+    if (ret == nullptr) [[unlikely]] {
+        throwOutOfMemory(size, alignment, totalCapacity - get_size());
+    }
+    return ret;
+}
+
+template<typename Backing>
+bool initial_buffer_pool<Backing>::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    pool* active = &initial;
+    if (initialBufferClosed.load(std::memory_order_acquire)) {
+        // Closing the buffer comes after creating the backing pool.
+        active = backing.load(std::memory_order_acquire);
+    }
+    if (newSize > oldSize) {
+        return active->try_extend(p, oldSize, newSize);
+    }
+    const auto size = get_size();
+    if (!active->shrink(p, oldSize, newSize)) {
+        return false;
+    }
+    // Save the peak that shrinking lowered, unless another thread saved a higher one.
+    auto peak = peakBytesBeforeRewind.load();
+    while (peak < size && !peakBytesBeforeRewind.compare_exchange(peak, size)) {
+    }
+    return true;
+}
+
+template<typename Backing>
+Backing* initial_buffer_pool<Backing>::get_or_create_backing() {
+    if (auto* backingPool = backing.load(std::memory_order_acquire)) [[likely]] {
+        initialBufferClosed.store(true, std::memory_order_release);
+        return backingPool;
+    }
+    if (totalCapacity == initial.get_capacity()) {
+        // The buffer was the whole pool.
+        return nullptr;
+    }
+    std::lock_guard lock(backingMutex);
+    if (ownedBacking == nullptr) {
+        ownedBacking = std::make_unique<Backing>(totalCapacity - initial.get_capacity(), options);
+        backing.store(ownedBacking.get(), std::memory_order_release);
+    }
+    initialBufferClosed.store(true, std::memory_order_release);
+    return ownedBacking.get();
+}
+
+template class initial_buffer_pool<simple_pool>;
+template class initial_buffer_pool<lock_free_pool>;
+
+child_pool::child_pool(pool& parent, const size_t capacity)
+    : parent(parent), capacity(capacity) {
+}
+
+child_pool::~child_pool() {
+    run_destructors();
+    release_block();
+}
+
+size_t child_pool::get_capacity() const {
+    return capacity;
+}
+
+size_t child_pool::get_size() const {
+    return bytesInUse.load(std::memory_order_relaxed);
+}
+
+size_t child_pool::get_alignment_fragmentation() const {
+    return alignmentFragmentationBytes.load(std::memory_order_relaxed);
+}
+
+size_t child_pool::get_committed_size() const {
+    return blockSize;
+}
+
+size_t child_pool::get_resident_size() const {
+    if (blockSize == 0) {
+        return 0;
+    }
+    auto* firstPage = get_containing_page(blockStart);
+    auto* endPage = get_containing_page(blockStart + blockSize - 1) + get_page_size();
+    return get_resident_bytes(firstPage, endPage - firstPage);
+}
+
+int child_pool::get_numa_node() const {
+    return parent.get_numa_node();
+}
+
+size_t child_pool::get_peak_size() const {
+    return std::max(peakBytesBeforeRewind, get_size());
+}
+
+size_t child_pool::trim() {
+    return 0;
+}
+
+void child_pool::reset() {
+    rewind(pool_marker{});
+}
+
+pool_marker child_pool::mark() const {
+    return {bytesInUse.load(std::memory_order_relaxed), alignmentFragmentationBytes.load(std::memory_order_relaxed),
+            get_last_destructor()};
+}
+
+void child_pool::rewind(const pool_marker& marker) {
+    checkMarker(marker, bytesInUse.load(std::memory_order_relaxed));
+    run_destructors(marker.lastDestructor);
+    peakBytesBeforeRewind = get_peak_size();
+    if (blockStart != nullptr && marker.position >= blockStartPosition) {
+        blockUsed = marker.position - blockStartPosition;
+        if (parent.shrink(blockStart, blockSize, blockUsed)) {
+            blockSize = blockUsed;
+        }
+    } else {
+        // The marker is in an earlier block, which the parent has allocated after.
+        release_block();
+    }
+    bytesInUse.store(marker.position, std::memory_order_relaxed);
+    alignmentFragmentationBytes.store(marker.alignmentFragmentation, std::memory_order_relaxed);
+}
+
+void* child_pool::do_allocate(const std::size_t size, const std::size_t alignment) {
+    const auto offset = bytesInUse.load(std::memory_order_relaxed);
+    if (capacity - offset < size) [[unlikely]] {
+        throwOutOfMemory(size, alignment, capacity - offset);
+    }
+    if (blockStart != nullptr) {
+        const auto alignmentSkip = computeAlignmentSkip(blockStart + blockUsed, alignment);
+        if (capacity - offset - size < alignmentSkip) [[unlikely]] {
+            throwOutOfMemory(size, alignment, capacity - offset);
+        }
+        const auto newBlockUsed = blockUsed + alignmentSkip + size;
+        if (newBlockUsed <= blockSize || parent.try_extend(blockStart, blockSize, newBlockUsed)) [[likely]] {
+            metrics::record_allocation(size, alignment);
+            auto* ret = blockStart + blockUsed + alignmentSkip;
+            blockSize = std::max(blockSize, newBlockUsed);
+            blockUsed = newBlockUsed;
+            bytesInUse.store(offset + alignmentSkip + size, std::memory_order_relaxed);
+            if (alignmentSkip != 0) {
+                alignmentFragmentationBytes.fetch_add(alignmentSkip, std::memory_order_relaxed);
+            }
+            return ret;
+        }
+    }
+    // Start a new block at the parent's end. The parent counts the allocation. The old block still holds
+    // allocations, so it stays with the parent.
+    auto* ret = static_cast<char*>(parent.allocate(size, std::max(alignment, alignof(std::max_align_t))));
+    blockStart = ret;
+    blockSize = size;
+    blockUsed = size;
+    blockStartPosition = offset;
+    bytesInUse.store(offset + size, std::memory_order_relaxed);
+    return ret;
+}
+
+bool child_pool::do_resize(void* p, const std::size_t oldSize, const std::size_t newSize) {
+    const auto start = static_cast<char*>(p);
+    if (blockStart == nullptr || start < blockStart || start > blockStart + blockUsed ||
+        static_cast<size_t>(blockStart + blockUsed - start) != oldSize) {
+        return false;
+    }
+    const auto offset = bytesInUse.load(std::memory_order_relaxed);
+    if (newSize > oldSize && capacity - offset < newSize - oldSize) {
+        return false;
+    }
+    const auto newBlockUsed = blockUsed - oldSize + newSize;
+    if (newBlockUsed > blockSize) {
+        if (!parent.try_extend(blockStart, blockSize, newBlockUsed)) {
+            return false;
+        }
+        blockSize = newBlockUsed;
+    } else if (newSize < oldSize) {
+        peakBytesBeforeRewind = get_peak_size();
+        if (parent.shrink(blockStart, blockSize, newBlockUsed)) {
+            blockSize = newBlockUsed;
+        }
+    }
+    blockUsed = newBlockUsed;
+    bytesInUse.store(offset - oldSize + newSize, std::memory_order_relaxed);
+    return true;
+}
+
+void child_pool::release_block() {
+    if (blockStart != nullptr) {
+        // Shrinking, unlike deallocating, never lets a Recycling parent reuse a block it didn't hand out whole.
+        (void)parent.shrink(blockStart, blockSize, 0);
+        blockStart = nullptr;
+        blockSize = 0;
+        blockUsed = 0;
+    }
 }
@@ -0,0 +1,140 @@
+#include "metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <vector>
+
+using namespace memory_pool;
+
+#ifdef MEMORY_POOL_METRICS
+
+namespace {
+    // One thread's counters. Only the owning thread writes them, so updates need no read-modify-write, and a
+    // thread reading the metrics sees each counter whole.
+    struct thread_counters {
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> allocatedBytes = 0;
+        std::atomic<uint64_t> deallocations = 0;
+        std::atomic<uint64_t> sizeHistogram[pool_metrics::sizeBuckets] = {};
+        std::atomic<uint64_t> alignmentHistogram[pool_metrics::alignmentBuckets] = {};
+        std::atomic<uint64_t> commits = 0;
+        std::atomic<uint64_t> commitNanoseconds = 0;
+        std::atomic<uint64_t> lockWaits = 0;
+        std::atomic<uint64_t> lockWaitNanoseconds = 0;
+
+        // Adds these counters to a snapshot.
+        void add_to(pool_metrics& metrics) const {
+            metrics.allocations += allocations.load(std::memory_order_relaxed);
+            metrics.allocatedBytes += allocatedBytes.load(std::memory_order_relaxed);
+            metrics.deallocations += deallocations.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < pool_metrics::sizeBuckets; ++i) {
+                metrics.sizeHistogram[i] += sizeHistogram[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < pool_metrics::alignmentBuckets; ++i) {
+                metrics.alignmentHistogram[i] += alignmentHistogram[i].load(std::memory_order_relaxed);
+            }
+            metrics.commits += commits.load(std::memory_order_relaxed);
+            metrics.commitNanoseconds += commitNanoseconds.load(std::memory_order_relaxed);
+            metrics.lockWaits += lockWaits.load(std::memory_order_relaxed);
+            metrics.lockWaitNanoseconds += lockWaitNanoseconds.load(std::memory_order_relaxed);
+        }
+    };
+
+    void increment(std::atomic<uint64_t>& counter, const uint64_t amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Every live thread's counters, and the totals of threads that have exited.
+    class counters_registry {
+        std::mutex mutex;
+        std::vector<const thread_counters*> threads;
+        pool_metrics exitedThreads;
+
+    public:
+        void add(const thread_counters* counters) {
+            std::lock_guard lock(mutex);
+            threads.push_back(counters);
+        }
+
+        void remove(const thread_counters* counters) {
+            std::lock_guard lock(mutex);
+            counters->add_to(exitedThreads);
+            std::erase(threads, counters);
+        }
+
+        [[nodiscard]] pool_metrics snapshot() {
+            std::lock_guard lock(mutex);
+            auto metrics = exitedThreads;
+            for (const auto* counters : threads) {
+                counters->add_to(metrics);
+            }
+            return metrics;
+        }
+    };
+
+    counters_registry& registry() {
+        // Never destroyed, so threads exiting during static destruction can still report.
+        static auto* instance = new counters_registry();
+        return *instance;
+    }
+
+    class registered_counters {
+    public:
+        thread_counters counters;
+
+        registered_counters() {
+            registry().add(&counters);
+        }
+
+        ~registered_counters() {
+            registry().remove(&counters);
+        }
+    };
+
+    thread_counters& local_counters() {
+        thread_local registered_counters local;
+        return local.counters;
+    }
+}
+
+void metrics::record_allocation(const size_t size, const size_t alignment) {
+    auto& counters = local_counters();
+    increment(counters.allocations);
+    increment(counters.allocatedBytes, size);
+    increment(counters.sizeHistogram[std::bit_width(size)]);
+    increment(counters.alignmentHistogram[std::min<size_t>(std::countr_zero(alignment),
+                                                           pool_metrics::alignmentBuckets - 1)]);
+}
+
+void metrics::record_deallocation() {
+    increment(local_counters().deallocations);
+}
+
+void metrics::record_commit(const uint64_t nanoseconds) {
+    auto& counters = local_counters();
+    increment(counters.commits);
+    increment(counters.commitNanoseconds, nanoseconds);
+}
+
+void metrics::record_lock_wait(const uint64_t nanoseconds) {
+    auto& counters = local_counters();
+    increment(counters.lockWaits);
+    increment(counters.lockWaitNanoseconds, nanoseconds);
+}
+
+uint64_t metrics::now_nanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+pool_metrics pool::get_metrics() {
+    auto metrics = registry().snapshot();
+    metrics.enabled = true;
+    return metrics;
+}
+#else
+pool_metrics pool::get_metrics() {
+    return {};
+}
+#endif
@@ -0,0 +1,115 @@
+#include "internal.h"
+
+reservation_cache& reservation_cache::instance() {
+    // Never destroyed, so pools destroyed during static destruction can still give their reservations back.
+    static auto* cache = new reservation_cache();
+    return *cache;
+}
+
+std::vector<reservation_cache::entry> reservation_cache::configure(const reservation_cache_options& newOptions) {
+    std::lock_guard lock(mutex);
+    options = newOptions;
+    std::vector<entry> evicted;
+    while (!entries.empty() && (entries.size() > options.maxReservations ||
+                                (options.maxBytes != 0 && cachedBytes > options.maxBytes))) {
+        evicted.push_back(entries.front());
+        cachedBytes -= entries.front().size;
+        entries.erase(entries.begin());
+        ++evictions;
+    }
+    return evicted;
+}
+
+reservation_cache_statistics reservation_cache::get_statistics() {
+    std::lock_guard lock(mutex);
+    return {hits, misses, evictions, entries.size(), cachedBytes};
+}
+
+reservation_cache_options reservation_cache::get_options() {
+    std::lock_guard lock(mutex);
+    return options;
+}
+
+bool reservation_cache::take(const size_t size, const huge_pages hugePages, const commit_mode commitMode,
+                             entry& taken) {
+    std::lock_guard lock(mutex);
+    if (options.maxReservations == 0) {
+        return false;
+    }
+    // Newest first, since its pages are the likeliest to still be resident.
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->size == size && it->hugePages == hugePages && it->commitMode == commitMode) {
+            taken = *it;
+            cachedBytes -= size;
+            entries.erase(std::next(it).base());
+            ++hits;
+            return true;
+        }
+    }
+    ++misses;
+    return false;
+}
+
+std::vector<reservation_cache::entry> reservation_cache::put(const entry& released) {
+    std::lock_guard lock(mutex);
+    if (options.maxReservations == 0 || (options.maxBytes != 0 && released.size > options.maxBytes)) {
+        return {released};
+    }
+    std::vector<entry> evicted;
+    while (entries.size() >= options.maxReservations ||
+           (options.maxBytes != 0 && cachedBytes + released.size > options.maxBytes)) {
+        evicted.push_back(entries.front());
+        cachedBytes -= entries.front().size;
+        entries.erase(entries.begin());
+        ++evictions;
+    }
+    entries.push_back(released);
+    cachedBytes += released.size;
+    return evicted;
+}
+
+void pool::configure_reservation_cache(const reservation_cache_options& options) {
+    for (const auto& evicted : reservation_cache::instance().configure(options)) {
+        free_buffer(evicted.buffer, evicted.size);
+    }
+}
+
+reservation_cache_statistics pool::get_reservation_cache_statistics() {
+    return reservation_cache::instance().get_statistics();
+}
+
+char* pool::take_reservation(const size_t size, const huge_pages hugePages, const commit_mode commitMode,
+                             const numa_policy numaPolicy, size_t& committedBytes) {
+    // A cached reservation's pages may already be placed, so pools with a NUMA policy reserve their own.
+    reservation_cache::entry taken{};
+    if (numaPolicy == numa_policy::Default &&
+        reservation_cache::instance().take(size, hugePages, commitMode, taken)) {
+        committedBytes = taken.committedBytes;
+        return taken.buffer;
+    }
+    committedBytes = 0;
+    return reserve_buffer(size, hugePages, commitMode);
+}
+
+void pool::give_back_reservation(char* buffer, const size_t size, const huge_pages hugePages,
+                                 const commit_mode commitMode, const numa_policy numaPolicy,
+                                 size_t committedBytes) {
+    auto& cache = reservation_cache::instance();
+    const auto options = cache.get_options();
+    if (numaPolicy != numa_policy::Default || options.maxReservations == 0 ||
+        (options.maxBytes != 0 && size > options.maxBytes)) {
+        free_buffer(buffer, size);
+        return;
+    }
+    if (!options.keepWarm && committedBytes != 0) {
+        release_pages(buffer, committedBytes, decommit_policy::DontNeed);
+        // In commit_mode::Fault, committed means prefaulted, which released pages no longer are.
+        if (commitMode == commit_mode::Fault) {
+            committedBytes = 0;
+        }
+    }
+    // The limits may have changed since we looked, so the cache can still turn it away.
+    for (const auto& released : cache.put({buffer, size, hugePages, commitMode, committedBytes})) {
+        free_buffer(released.buffer, released.size);
+    }
+}
@@ -0,0 +1,227 @@
+#include "internal.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+slab_pool::slab_pool(const size_t capacity, const pool_options& options)
+    : arena(capacity, options),
+      threads([this](thread_entry& entry) {
+          // Give the exiting thread's blocks to the other threads.
+          auto& cache = static_cast<thread_cache&>(entry);
+          for (size_t sizeClass = 0; sizeClass < classCount; ++sizeClass) {
+              flush(cache, sizeClass, cache.counts[sizeClass]);
+          }
+      }) {
+}
+
+size_t slab_pool::get_capacity() const {
+    return arena.get_capacity();
+}
+
+size_t slab_pool::get_size() const {
+    size_t freeBytes = 0;
+    threads.for_each([&](const thread_entry& entry) {
+        freeBytes += static_cast<const thread_cache&>(entry).cachedBytes.load(std::memory_order_relaxed);
+    });
+    for (size_t sizeClass = 0; sizeClass < classCount; ++sizeClass) {
+        const auto& list = freeLists[sizeClass];
+        std::lock_guard lock(list.mutex);
+        freeBytes += list.count * get_block_size(sizeClass);
+    }
+    const auto carvedBytes = arena.get_size();
+    // Blocks moving between lists while we count can be counted twice.
+    return carvedBytes > freeBytes ? carvedBytes - freeBytes : 0;
+}
+
+size_t slab_pool::get_alignment_fragmentation() const {
+    return arena.get_alignment_fragmentation();
+}
+
+size_t slab_pool::get_committed_size() const {
+    return arena.get_committed_size();
+}
+
+size_t slab_pool::get_resident_size() const {
+    return arena.get_resident_size();
+}
+
+int slab_pool::get_numa_node() const {
+    return arena.get_numa_node();
+}
+
+size_t slab_pool::get_peak_size() const {
+    return arena.get_peak_size();
+}
+
+size_t slab_pool::trim() {
+    return arena.trim();
+}
+
+slab_pool::~slab_pool() {
+    run_destructors();
+}
+
+void slab_pool::reset() {
+    run_destructors();
+    threads.for_each([](thread_entry& entry) {
+        auto& cache = static_cast<thread_cache&>(entry);
+        std::fill(std::begin(cache.heads), std::end(cache.heads), nullptr);
+        std::fill(std::begin(cache.counts), std::end(cache.counts), 0);
+        cache.cachedBytes.store(0, std::memory_order_relaxed);
+    });
+    for (auto& list : freeLists) {
+        std::lock_guard lock(list.mutex);
+        list.head = nullptr;
+        list.count = 0;
+    }
+    arena.reset();
+}
+
+size_t slab_pool::get_size_class(const std::size_t size, const std::size_t alignment) {
+    const auto blockSize = std::max({size, alignment, static_cast<size_t>(1) << minBlockShift});
+    // Blocks are only aligned to powers of 2, so other alignments come straight from the arena.
+    if (blockSize > static_cast<size_t>(1) << maxBlockShift || alignment > maxBlockAlignment ||
+        !std::has_single_bit(alignment)) {
+        return classCount;
+    }
+    return std::bit_width(blockSize - 1) - minBlockShift;
+}
+
+size_t slab_pool::get_block_size(const size_t sizeClass) {
+    return static_cast<size_t>(1) << (sizeClass + minBlockShift);
+}
+
+size_t slab_pool::get_cache_limit(const size_t sizeClass) {
+    constexpr size_t cacheBytesPerClass = 64 * 1024;
+    return std::max<size_t>(2, cacheBytesPerClass / get_block_size(sizeClass));
+}
+
+void* slab_pool::do_allocate(const std::size_t size, const std::size_t alignment) {
+    metrics::record_allocation(size, alignment);
+    const auto sizeClass = get_size_class(size, alignment);
+    if (sizeClass == classCount) [[unlikely]] {
+        return take_from_arena(size, alignment);
+    }
+    auto& cache = *get_thread_cache();
+    if (cache.heads[sizeClass] == nullptr) [[unlikely]] {
+        refill(cache, sizeClass);
+    }
+    auto* block = cache.heads[sizeClass];
+    cache.heads[sizeClass] = block->next;
+    --cache.counts[sizeClass];
+    cache.cachedBytes.store(cache.cachedBytes.load(std::memory_order_relaxed) - get_block_size(sizeClass),
+                            std::memory_order_relaxed);
+    return block;
+}
+
+void slab_pool::do_allocate_bulk(const std::size_t count, const std::size_t size, const std::size_t alignment,
+                                 void** out) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = do_allocate(size, alignment);
+    }
+}
+
+void slab_pool::do_deallocate(void* p, const std::size_t size, const std::size_t alignment) {
+    metrics::record_deallocation();
+    const auto sizeClass = get_size_class(size, alignment);
+    if (sizeClass == classCount) [[unlikely]] {
+        return;
+    }
+    auto* block = static_cast<free_block*>(p);
+    auto* entry = threads.find();
+    if (entry == nullptr) [[unlikely]] {
+        // Giving this thread a cache could throw, which deallocate mustn't, so share the block straight away.
+        auto& list = freeLists[sizeClass];
+        std::lock_guard lock(list.mutex);
+        block->next = list.head;
+        list.head = block;
+        ++list.count;
+        return;
+    }
+    auto& cache = *static_cast<thread_cache*>(entry);
+    block->next = cache.heads[sizeClass];
+    cache.heads[sizeClass] = block;
+    cache.cachedBytes.store(cache.cachedBytes.load(std::memory_order_relaxed) + get_block_size(sizeClass),
+                            std::memory_order_relaxed);
+    const auto limit = get_cache_limit(sizeClass);
+    if (++cache.counts[sizeClass] > limit) [[unlikely]] {
+        flush(cache, sizeClass, limit / 2);
+    }
+}
+
+void* slab_pool::take_from_arena(const std::size_t size, const std::size_t alignment) {
+    auto* ret = arena.try_allocate(size, alignment);
+    if (ret == nullptr) [[unlikely]] {
+        throwOutOfMemory(size, alignment, arena.get_capacity() - arena.get_size());
+    }
+    return ret;
+}
+
+slab_pool::thread_cache* slab_pool::get_thread_cache() {
+    if (auto* entry = threads.find()) [[likely]] {
+        return static_cast<thread_cache*>(entry);
+    }
+    return static_cast<thread_cache*>(threads.add(std::make_unique<thread_cache>()));
+}
+
+void slab_pool::refill(thread_cache& cache, const size_t sizeClass) {
+    const auto blockSize = get_block_size(sizeClass);
+    const auto batch = get_cache_limit(sizeClass) / 2;
+    free_block* first;
+    free_block* last;
+    size_t count = 1;
+    auto& list = freeLists[sizeClass];
+    std::unique_lock lock(list.mutex);
+    if (list.head != nullptr) {
+        first = last = list.head;
+        while (count < batch && last->next != nullptr) {
+            last = last->next;
+            ++count;
+        }
+        list.head = last->next;
+        list.count -= count;
+        lock.unlock();
+    } else {
+        lock.unlock();
+        // Carve a batch of new blocks. Carving them together keeps each one aligned to its size.
+        const auto alignment = std::min(blockSize, maxBlockAlignment);
+        count = std::clamp<size_t>((arena.get_capacity() - arena.get_size()) / blockSize, 1, batch);
+        auto* blocks = static_cast<char*>(arena.try_allocate(count * blockSize, alignment));
+        if (blocks == nullptr) {
+            // The alignment didn't leave room for the whole batch.
+            count = 1;
+            blocks = static_cast<char*>(take_from_arena(blockSize, alignment));
+        }
+        first = reinterpret_cast<free_block*>(blocks);
+        for (size_t i = 0; i + 1 < count; ++i) {
+            reinterpret_cast<free_block*>(blocks + i * blockSize)->next =
+                reinterpret_cast<free_block*>(blocks + (i + 1) * blockSize);
+        }
+        last = reinterpret_cast<free_block*>(blocks + (count - 1) * blockSize);
+    }
+    last->next = cache.heads[sizeClass];
+    cache.heads[sizeClass] = first;
+    cache.counts[sizeClass] += count;
+    cache.cachedBytes.store(cache.cachedBytes.load(std::memory_order_relaxed) + count * blockSize,
+                            std::memory_order_relaxed);
+}
+
+void slab_pool::flush(thread_cache& cache, const size_t sizeClass, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+    auto* first = cache.heads[sizeClass];
+    auto* last = first;
+    for (size_t i = 1; i < count; ++i) {
+        last = last->next;
+    }
+    cache.heads[sizeClass] = last->next;
+    cache.counts[sizeClass] -= count;
+    cache.cachedBytes.store(cache.cachedBytes.load(std::memory_order_relaxed) - count * get_block_size(sizeClass),
+                            std::memory_order_relaxed);
+    auto& list = freeLists[sizeClass];
+    std::lock_guard lock(list.mutex);
+    last->next = list.head;
+    list.head = first;
+    list.count += count;
+}
@@ -0,0 +1,156 @@
+#include "internal.h"
+#include <algorithm>
+
+namespace {
+    std::atomic<uint64_t> nextRegistryId = 0;
+
+    // Hands out registry slots, reusing those of destroyed registries so threads' slot tables stay small.
+    class slot_allocator {
+        std::mutex mutex;
+        std::vector<size_t> freeSlots;
+        size_t slotCount = 0;
+
+    public:
+        size_t take() {
+            std::lock_guard lock(mutex);
+            if (freeSlots.empty()) {
+                return slotCount++;
+            }
+            const auto slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+
+        void give_back(const size_t slot) {
+            std::lock_guard lock(mutex);
+            freeSlots.push_back(slot);
+        }
+    };
+
+    slot_allocator& slots() {
+        static slot_allocator allocator;
+        return allocator;
+    }
+
+    // The entries the current thread has in registries, by slot, so they can be cleaned up when it exits.
+    class thread_registrations {
+        struct registration {
+            uint64_t registryId = UINT64_MAX;
+            std::weak_ptr<thread_registry::shared_state> state;
+            thread_entry* entry = nullptr;
+        };
+
+        std::vector<registration> bySlot;
+
+    public:
+        ~thread_registrations();
+
+        [[nodiscard]] thread_entry* find(const size_t slot, const uint64_t id) const {
+            if (slot < bySlot.size() && bySlot[slot].registryId == id) {
+                return bySlot[slot].entry;
+            }
+            return nullptr;
+        }
+
+        void add(const size_t slot, const uint64_t id, const std::shared_ptr<thread_registry::shared_state>& state,
+                 thread_entry* entry) {
+            if (bySlot.size() <= slot) {
+                bySlot.resize(slot + 1);
+            }
+            // Anything already here belongs to a destroyed registry.
+            bySlot[slot] = {id, state, entry};
+        }
+    };
+
+    thread_local thread_registrations registrations;
+}
+
+thread_registrations::~thread_registrations() {
+    lastFoundEntry = {};
+    for (auto& registration : bySlot) {
+        const auto state = registration.state.lock();
+        if (!state) {
+            continue;
+        }
+        std::lock_guard lock(state->mutex);
+        if (!state->alive) {
+            continue;
+        }
+        if (state->onThreadExit) {
+            state->onThreadExit(*registration.entry);
+        }
+        state->remove(registration.entry);
+    }
+}
+
+thread_registry::shared_state::~shared_state() {
+    clear();
+}
+
+void thread_registry::shared_state::remove(thread_entry* entry) {
+    auto* previous = &head;
+    while (previous->load(std::memory_order_relaxed) != entry) {
+        previous = &previous->load(std::memory_order_relaxed)->next;
+    }
+    previous->store(entry->next.load(std::memory_order_relaxed));
+    // A reader that starts after this sees the entry unlinked.
+    if (unlockedReaders.load() == 0) {
+        delete entry;
+        for (auto* retiredEntry : retired) {
+            delete retiredEntry;
+        }
+        retired.clear();
+    } else {
+        retired.push_back(entry);
+    }
+}
+
+void thread_registry::shared_state::clear() {
+    auto* entry = head.exchange(nullptr);
+    while (entry != nullptr) {
+        auto* next = entry->next.load(std::memory_order_relaxed);
+        delete entry;
+        entry = next;
+    }
+    for (auto* retiredEntry : retired) {
+        delete retiredEntry;
+    }
+    retired.clear();
+}
+
+thread_registry::thread_registry(exit_handler onThreadExit)
+    : state(std::make_shared<shared_state>()),
+      id(nextRegistryId++),
+      slot(slots().take()) {
+    state->onThreadExit = std::move(onThreadExit);
+}
+
+thread_registry::~thread_registry() {
+    {
+        // Waits for any exiting thread that is still using its entry.
+        std::lock_guard lock(state->mutex);
+        state->alive = false;
+        state->clear();
+    }
+    slots().give_back(slot);
+}
+
+thread_entry* thread_registry::find_slow() const {
+    auto* entry = registrations.find(slot, id);
+    if (entry != nullptr) {
+        lastFoundEntry = {id, entry};
+    }
+    return entry;
+}
+
+thread_entry* thread_registry::add(std::unique_ptr<thread_entry> entry) {
+    auto* ret = entry.release();
+    {
+        std::lock_guard lock(state->mutex);
+        ret->next.store(state->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        state->head.store(ret);
+    }
+    registrations.add(slot, id, state, ret);
+    lastFoundEntry = {id, ret};
+    return ret;
+}
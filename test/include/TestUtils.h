@@ -1,8 +1,35 @@
 #pragma once
 #include "memory-pool/memory_pool.h"
+#include <gtest/gtest.h>
+#include <string>
 
 void usePool(memory_pool::pool& pool, size_t chunkSize);
 
 void useMemory(void* buffer, size_t size);
 
-void assertPoolFull(memory_pool::pool& pool);
\ No newline at end of file
+void assertPoolFull(memory_pool::pool& pool);
+
+const char* poolTypeName(memory_pool::pool_type type);
+
+// Names each instantiation of a test parameterized by pool type after the type.
+std::string poolTypeParamName(const testing::TestParamInfo<memory_pool::pool_type>& info);
+
+// A fixture for tests parameterized by pool type. Suites alias it, e.g. using Reset = PoolTypeTest;
+class PoolTypeTest : public testing::TestWithParam<memory_pool::pool_type> {
+};
+
+inline const auto allPoolTypes = testing::Values(
+    memory_pool::pool_type::SingleThreaded,
+    memory_pool::pool_type::ThreadSafe,
+    memory_pool::pool_type::ThreadBuffered,
+    memory_pool::pool_type::PerCpu,
+    memory_pool::pool_type::PerThread,
+    memory_pool::pool_type::Locked,
+    memory_pool::pool_type::Recycling);
+
+// The types that know their most recent allocation.
+inline const auto stackPoolTypes = testing::Values(
+    memory_pool::pool_type::SingleThreaded,
+    memory_pool::pool_type::ThreadSafe,
+    memory_pool::pool_type::PerThread,
+    memory_pool::pool_type::Locked);
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+    constexpr size_t window = 16 * MB;
+
+    pool_options backgroundOptions() {
+        pool_options options;
+        options.backgroundCommitBytes = window;
+        return options;
+    }
+
+    // Waits for the background committer to commit at least the given number of bytes.
+    bool waitForCommitted(const pool& pool, const size_t bytes) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pool.get_committed_size() < bytes) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+using BackgroundCommit = PoolTypeTest;
+
+TEST_P(BackgroundCommit, CommitsAheadOfAllocations) {
+    auto* pool = pool::create(256 * MB, GetParam(), backgroundOptions());
+    for (size_t i = 0; i < 40; ++i)
+        useMemory(pool->new_buffer(MB), MB);
+    EXPECT_TRUE(waitForCommitted(*pool, pool->get_size() + window / 2));
+    delete pool;
+}
+
+TEST_P(BackgroundCommit, StaysWithinWindow) {
+    auto* pool = pool::create(256 * MB, GetParam(), backgroundOptions());
+    for (size_t i = 0; i < 40; ++i)
+        useMemory(pool->new_buffer(MB), MB);
+    (void)waitForCommitted(*pool, pool->get_size() + window / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_LE(pool->get_committed_size(), pool->get_size() + window + MB);
+    delete pool;
+}
+
+TEST_P(BackgroundCommit, FillsCapacity) {
+    constexpr auto size = 40 * MB + 17;
+    auto* pool = pool::create(size, GetParam(), backgroundOptions());
+    for (size_t i = 0; i < size / 1000; ++i)
+        useMemory(pool->new_buffer(1000), 1000);
+    useMemory(pool->new_buffer(size % 1000), size % 1000);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_P(BackgroundCommit, SmallerThanWindow) {
+    constexpr auto size = 256 * 1024;
+    auto* pool = pool::create(size, GetParam(), backgroundOptions());
+    for (int round = 0; round < 10; ++round) {
+        for (size_t i = 0; i < size / 64; ++i)
+            useMemory(pool->new_buffer(64), 64);
+        assertPoolFull(*pool);
+        EXPECT_GE(pool->get_committed_size(), size);
+        pool->reset();
+    }
+    delete pool;
+}
+
+TEST_P(BackgroundCommit, PoolsComeAndGo) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 20; ++i) {
+                auto* pool = pool::create(64 * MB, GetParam(), backgroundOptions());
+                for (int j = 0; j < 20; ++j)
+                    useMemory(pool->new_buffer(MB), MB);
+                delete pool;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, BackgroundCommit, testing::Values(
+                             pool_type::SingleThreaded,
+                             pool_type::ThreadSafe,
+                             pool_type::Locked),
+                         poolTypeParamName);
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "memory-pool/basic_pool.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+template<typename Pool>
+class BasicPool : public testing::Test {
+};
+
+using BasicPoolTypes = testing::Types<
+    basic_pool<single_threaded, commit_ahead>,
+    basic_pool<single_threaded, commit_on_fault>,
+    basic_pool<thread_safe, commit_ahead>,
+    basic_pool<thread_safe, commit_on_fault>>;
+TYPED_TEST_SUITE(BasicPool, BasicPoolTypes);
+
+TYPED_TEST(BasicPool, AllocatesUntilFull) {
+    TypeParam pool(1000);
+    useMemory(pool.template allocate<1>(600), 600);
+    useMemory(pool.allocate(400, 1), 400);
+    EXPECT_EQ(1000, pool.get_size());
+    EXPECT_EQ(nullptr, pool.try_allocate(1, 1));
+    EXPECT_THROW((void)pool.template allocate<1>(1), std::invalid_argument);
+}
+
+TYPED_TEST(BasicPool, Alignment) {
+    TypeParam pool(1 << 20);
+    useMemory(pool.template allocate<1>(1), 1);
+    auto* aligned = pool.template allocate<64>(8);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 64);
+    EXPECT_EQ(63, pool.get_alignment_fragmentation());
+    auto* object = pool.template new_object<uint64_t>(5);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(object) % alignof(uint64_t));
+    EXPECT_EQ(5, *object);
+}
+
+TYPED_TEST(BasicPool, CommitsAsItGrows) {
+    TypeParam pool(16 << 20);
+    useMemory(pool.template allocate<1>(3 << 20), 3 << 20);
+    EXPECT_GE(pool.get_committed_size(), 3 << 20);
+    EXPECT_LE(pool.get_committed_size(), 16 << 20);
+}
+
+TYPED_TEST(BasicPool, MarkAndRewind) {
+    TypeParam pool(1000);
+    useMemory(pool.template allocate<1>(100), 100);
+    const auto marker = pool.mark();
+    useMemory(pool.template allocate<1>(200), 200);
+    pool.rewind(marker);
+    EXPECT_EQ(100, pool.get_size());
+    EXPECT_EQ(300, pool.get_peak_size());
+    pool.reset();
+    EXPECT_EQ(0, pool.get_size());
+    EXPECT_THROW(pool.rewind(marker), std::invalid_argument);
+}
+
+TYPED_TEST(BasicPool, UsableAsPool) {
+    TypeParam basicPool(1 << 20);
+    pool& asPool = basicPool;
+    useMemory(asPool.new_buffer(100, 8), 100);
+    EXPECT_EQ(100, asPool.get_size());
+    std::pmr::vector<int> numbers(&asPool);
+    numbers.assign(100, 1);
+    EXPECT_EQ(100, numbers.size());
+}
+
+TYPED_TEST(BasicPool, AlignmentNotPowerOf2) {
+    TypeParam basicPool(1 << 20);
+    pool& asPool = basicPool;
+    useMemory(asPool.new_buffer(1, 1), 1);
+    auto* aligned = asPool.new_buffer(10, 24);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 24);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(basicPool.allocate(10, 24)) % 24);
+}
+
+TEST(BasicPool, CallerBuffer) {
+    alignas(64) char buffer[1000];
+    basic_pool<single_threaded, commit_on_fault> pool(buffer, sizeof(buffer));
+    auto* first = static_cast<char*>(pool.allocate<1>(600));
+    EXPECT_EQ(buffer, first);
+    useMemory(pool.allocate(400, 1), 400);
+    EXPECT_EQ(nullptr, pool.try_allocate(1, 1));
+    EXPECT_EQ(sizeof(buffer), pool.get_committed_size());
+}
+
+TEST(BasicPool, ThreadSafeAllocationsAreDistinct) {
+    basic_pool<thread_safe> pool(1 << 24);
+    constexpr int threadCount = 4;
+    constexpr int perThread = 10000;
+    std::vector<std::vector<char*>> allocations(threadCount);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < perThread; ++j) {
+                allocations[i].push_back(static_cast<char*>(pool.allocate<8>(24)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::vector<char*> all;
+    for (const auto& list : allocations) {
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    std::sort(all.begin(), all.end());
+    for (size_t i = 1; i < all.size(); ++i) {
+        EXPECT_GE(all[i] - all[i - 1], 24);
+    }
+    EXPECT_EQ(threadCount * perThread * 24, pool.get_size());
+}
@@ -0,0 +1,130 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    struct counted {
+        static int live;
+        int value;
+
+        explicit counted(const int value)
+            : value(value) {
+            if (live == 3) {
+                throw std::runtime_error("Too many");
+            }
+            ++live;
+        }
+
+        ~counted() {
+            --live;
+        }
+    };
+
+    int counted::live = 0;
+}
+
+using Bulk = PoolTypeTest;
+
+TEST_P(Bulk, BuffersAreAlignedAndDistinct) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    constexpr size_t count = 100;
+    void* buffers[count];
+    pool->new_buffers(count, 24, 16, buffers);
+    std::vector<char*> sorted;
+    for (auto* buffer : buffers) {
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buffer) % 16);
+        useMemory(buffer, 24);
+        sorted.push_back(static_cast<char*>(buffer));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 1; i < count; ++i) {
+        EXPECT_GE(sorted[i] - sorted[i - 1], 24);
+    }
+    EXPECT_GE(pool->get_size(), count * 24);
+    delete pool;
+}
+
+TEST_P(Bulk, OutOfMemory) {
+    auto* pool = pool::create(1000, GetParam());
+    void* buffers[2];
+    EXPECT_THROW(pool->new_buffers(2, 1 << 20, 1, buffers), std::invalid_argument);
+    delete pool;
+}
+
+TEST_P(Bulk, ArrayConstructsEachElement) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    auto* array = pool->new_array<int>(50, 7);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(7, array[i]);
+    }
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(array) % alignof(int));
+    delete pool;
+}
+
+TEST_P(Bulk, SpanHandsOutUntilFull) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    auto span = pool->new_span(100, 8);
+    EXPECT_EQ(100, span.get_remaining());
+    auto* first = span.try_new_object<uint64_t>(1);
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(first) % 8);
+    auto* second = span.try_take(3, 1);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(reinterpret_cast<char*>(first) + 8, second);
+    auto* third = span.try_take(8, 8);
+    ASSERT_NE(nullptr, third);
+    EXPECT_EQ(reinterpret_cast<char*>(first) + 16, third);
+    EXPECT_EQ(100 - 24, span.get_remaining());
+    EXPECT_EQ(nullptr, span.try_take(100, 1));
+    EXPECT_NE(nullptr, span.try_take(76, 1));
+    EXPECT_EQ(0, span.get_remaining());
+    EXPECT_EQ(nullptr, span.try_take(1, 1));
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Bulk, allPoolTypes, poolTypeParamName);
+
+TEST(Bulk, BatchIsOneAllocation) {
+    auto* pool = pool::create(1000, pool_type::SingleThreaded);
+    void* buffers[10];
+    pool->new_buffers(10, 7, 4, buffers);
+    // Padded to a stride of 8, so every buffer is aligned.
+    EXPECT_EQ(static_cast<char*>(buffers[0]) + 72, buffers[9]);
+    EXPECT_EQ(80, pool->get_size());
+    delete pool;
+}
+
+TEST(Bulk, EmptyBatch) {
+    auto* pool = pool::create(1000, pool_type::SingleThreaded);
+    pool->new_buffers(0, 8, 8, nullptr);
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+TEST(Bulk, RecyclingBuffersAreReusedSeparately) {
+    auto* pool = pool::create(1 << 20, pool_type::Recycling);
+    void* buffers[4];
+    pool->new_buffers(4, 64, 8, buffers);
+    pool->deallocate(buffers[2], 64, 8);
+    EXPECT_EQ(buffers[2], pool->allocate(64, 8));
+    delete pool;
+}
+
+TEST(Bulk, ArrayConstructorThrows) {
+    auto* pool = pool::create(1000, pool_type::SingleThreaded);
+    counted::live = 0;
+    EXPECT_THROW((void)pool->new_array<counted>(5, 1), std::runtime_error);
+    EXPECT_EQ(0, counted::live);
+    delete pool;
+}
+
+TEST(Bulk, ArrayTooLarge) {
+    auto* pool = pool::create(1000, pool_type::SingleThreaded);
+    EXPECT_THROW((void)pool->new_array<uint64_t>(SIZE_MAX / 4), std::bad_array_new_length);
+    delete pool;
+}
@@ -0,0 +1,277 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+using ChildPool = PoolTypeTest;
+
+TEST_P(ChildPool, SizeRollsUpToParent) {
+    auto* parent = pool::create(10000, GetParam());
+    (void)parent->allocate(64, 16);
+    auto* child = parent->create_child(1000);
+    useMemory(child->allocate(100, 1), 100);
+    useMemory(child->allocate(200, 1), 200);
+    EXPECT_EQ(300, child->get_size());
+    EXPECT_EQ(1000, child->get_capacity());
+    EXPECT_EQ(364, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, DestroyingGivesSpaceBack) {
+    auto* parent = pool::create(10000, GetParam());
+    (void)parent->allocate(64, 16);
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(500, 1);
+    delete child;
+    EXPECT_EQ(64, parent->get_size());
+    delete parent;
+}
+
+TEST_P(ChildPool, ResetGivesSpaceBack) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(500, 1);
+    child->reset();
+    EXPECT_EQ(0, child->get_size());
+    EXPECT_EQ(500, child->get_peak_size());
+    EXPECT_EQ(0, parent->get_size());
+
+    // The child carries on from the start of its block.
+    (void)child->allocate(100, 1);
+    EXPECT_EQ(100, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, RewindGivesSpaceBack) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(100, 1);
+    const auto marker = child->mark();
+    (void)child->allocate(300, 1);
+    child->rewind(marker);
+    EXPECT_EQ(100, child->get_size());
+    EXPECT_EQ(100, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, CapacityIsEnforced) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(1000, 1);
+    EXPECT_THROW((void)child->allocate(1, 1), std::invalid_argument);
+    EXPECT_EQ(1000, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, ParentFullThrows) {
+    auto* parent = pool::create(1000, GetParam());
+    auto* child = parent->create_child(5000);
+    (void)child->allocate(800, 1);
+    EXPECT_THROW((void)child->allocate(400, 1), std::invalid_argument);
+    EXPECT_EQ(800, child->get_size());
+    delete child;
+    EXPECT_EQ(0, parent->get_size());
+    delete parent;
+}
+
+TEST_P(ChildPool, ParentAllocationMovesChildToNewBlock) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    auto* first = static_cast<char*>(child->allocate(96, 1));
+    (void)parent->allocate(64, 16);
+    auto* second = static_cast<char*>(child->allocate(32, 1));
+    EXPECT_EQ(first + 160, second);
+    EXPECT_EQ(128, child->get_size());
+    EXPECT_EQ(192, parent->get_size());
+
+    // Only the newest block can go back.
+    delete child;
+    EXPECT_EQ(160, parent->get_size());
+    delete parent;
+}
+
+TEST_P(ChildPool, RewindToEarlierBlock) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(96, 1);
+    const auto marker = child->mark();
+    (void)child->allocate(32, 1);
+    (void)parent->allocate(64, 16);
+    (void)child->allocate(32, 1);
+    child->rewind(marker);
+    EXPECT_EQ(96, child->get_size());
+    EXPECT_EQ(192, parent->get_size());
+
+    (void)child->allocate(32, 1);
+    EXPECT_EQ(128, child->get_size());
+    EXPECT_EQ(224, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, DeallocateGivesSpaceBack) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(1000);
+    auto* first = child->allocate(100, 1);
+    auto* second = child->allocate(200, 1);
+    child->deallocate(second, 200, 1);
+    child->deallocate(first, 100, 1);
+    EXPECT_EQ(0, child->get_size());
+    EXPECT_EQ(0, parent->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPool, BufferGrowsInPlace) {
+    auto* parent = pool::create(1 << 20, GetParam());
+    auto* child = parent->create_child(1 << 16);
+    {
+        pool_buffer<int> values(*child);
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(i);
+        }
+        EXPECT_EQ(values.get_capacity() * sizeof(int), child->get_size());
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(i, values[i]);
+        }
+    }
+    delete child;
+    EXPECT_EQ(0, parent->get_size());
+    delete parent;
+}
+
+TEST_P(ChildPool, GrandchildRollsUp) {
+    auto* parent = pool::create(10000, GetParam());
+    auto* child = parent->create_child(5000);
+    (void)child->allocate(96, 1);
+    auto* grandchild = child->create_child(1000);
+    (void)grandchild->allocate(200, 1);
+    EXPECT_EQ(296, child->get_size());
+    EXPECT_EQ(296, parent->get_size());
+    delete grandchild;
+    EXPECT_EQ(96, parent->get_size());
+    delete child;
+    EXPECT_EQ(0, parent->get_size());
+    delete parent;
+}
+
+TEST_P(ChildPool, RunsDestructors) {
+    pool_options options;
+    options.runDestructors = true;
+    auto* parent = pool::create(10000, GetParam(), options);
+    auto* child = parent->create_child(1000);
+    auto destroyed = std::make_shared<int>(0);
+    struct counter {
+        std::shared_ptr<int> count;
+
+        ~counter() {
+            ++*count;
+        }
+    };
+    (void)child->new_object<counter>(destroyed);
+    child->reset();
+    EXPECT_EQ(1, *destroyed);
+    (void)child->new_object<counter>(destroyed);
+    delete child;
+    EXPECT_EQ(2, *destroyed);
+    delete parent;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, ChildPool, stackPoolTypes, poolTypeParamName);
+
+// Parents of every type, including those that can't resize allocations and so never get space back.
+using ChildPoolAnyParent = PoolTypeTest;
+
+TEST_P(ChildPoolAnyParent, AllocationsSurviveParentAllocations) {
+    auto* parent = pool::create(1 << 20, GetParam());
+    auto* child = parent->create_child(1 << 16);
+    std::vector<unsigned char*> buffers;
+    for (int i = 0; i < 20; ++i) {
+        auto* buffer = static_cast<unsigned char*>(child->allocate(100, 1));
+        std::fill_n(buffer, 100, static_cast<unsigned char>(i));
+        buffers.push_back(buffer);
+        // Moves the child to a new block, which must not free the old one.
+        std::fill_n(static_cast<unsigned char*>(parent->allocate(100, 1)), 100, 0xFF);
+    }
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 100; ++j) {
+            ASSERT_EQ(i, buffers[i][j]);
+        }
+    }
+    EXPECT_EQ(2000, child->get_size());
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPoolAnyParent, ResetKeepsParentAllocations) {
+    auto* parent = pool::create(1 << 20, GetParam());
+    auto* child = parent->create_child(1 << 16);
+    (void)child->allocate(100, 1);
+    auto* parentBuffer = static_cast<unsigned char*>(parent->allocate(100, 1));
+    std::fill_n(parentBuffer, 100, 0xAB);
+    child->reset();
+    for (int i = 0; i < 10; ++i) {
+        std::fill_n(static_cast<unsigned char*>(child->allocate(100, 1)), 100, 0);
+    }
+    for (int j = 0; j < 100; ++j) {
+        ASSERT_EQ(0xAB, parentBuffer[j]);
+    }
+    delete child;
+    delete parent;
+}
+
+TEST_P(ChildPoolAnyParent, CapacityIsEnforced) {
+    auto* parent = pool::create(1 << 20, GetParam());
+    auto* child = parent->create_child(1000);
+    (void)child->allocate(1000, 1);
+    EXPECT_THROW((void)child->allocate(1, 1), std::invalid_argument);
+    EXPECT_EQ(1000, child->get_size());
+    delete child;
+    delete parent;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, ChildPoolAnyParent, allPoolTypes, poolTypeParamName);
+
+TEST(ChildPool, OnePerThreadInSharedParent) {
+    constexpr int threadCount = 4;
+    constexpr int rounds = 100;
+    auto* parent = pool::create(threadCount * 100000, pool_type::ThreadSafe);
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([parent, &failures, t] {
+            for (int round = 0; round < rounds; ++round) {
+                auto* child = parent->create_child(100000);
+                std::vector<int*> values;
+                for (int i = 0; i < 100; ++i) {
+                    auto* value = child->new_object<int>(t * 1000 + i);
+                    values.push_back(value);
+                }
+                for (int i = 0; i < 100; ++i) {
+                    if (*values[i] != t * 1000 + i) {
+                        ++failures;
+                    }
+                }
+                EXPECT_EQ(100 * sizeof(int), child->get_size());
+                delete child;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, failures);
+    EXPECT_LE(parent->get_size(), threadCount * rounds * 100 * (sizeof(int) + alignof(std::max_align_t)));
+    delete parent;
+}
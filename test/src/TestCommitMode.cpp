@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    pool_options faultOptions(const size_t prefaultBytes) {
+        pool_options options;
+        options.commitMode = commit_mode::Fault;
+        options.prefaultBytes = prefaultBytes;
+        return options;
+    }
+}
+
+using FaultCommit = PoolTypeTest;
+
+TEST_P(FaultCommit, WholeReservationUsableUpFront) {
+    auto* pool = pool::create(64 * MB, GetParam(), faultOptions(0));
+    EXPECT_EQ(64 * MB, pool->get_committed_size());
+    EXPECT_EQ(0, pool->get_resident_size());
+    useMemory(pool->new_buffer(3 * MB), 3 * MB);
+    EXPECT_GE(pool->get_resident_size(), 3 * MB);
+    delete pool;
+}
+
+TEST_P(FaultCommit, FillsCapacity) {
+    constexpr auto size = 10 * MB + 3;
+    auto* pool = pool::create(size, GetParam(), faultOptions(0));
+    useMemory(pool->new_buffer(size), size);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_P(FaultCommit, PrefaultsAhead) {
+    auto* pool = pool::create(64 * MB, GetParam(), faultOptions(4 * MB));
+    EXPECT_EQ(4 * MB, pool->get_committed_size());
+    useMemory(pool->new_buffer(5 * MB), 5 * MB);
+    EXPECT_GE(pool->get_committed_size(), 5 * MB);
+    EXPECT_EQ(0, pool->get_committed_size() % (4 * MB));
+    for (int i = 0; i < 59; ++i)
+        useMemory(pool->new_buffer(MB), MB);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_P(FaultCommit, TrimReleasesFaultedPages) {
+    auto* pool = pool::create(64 * MB, GetParam(), faultOptions(0));
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    pool->reset();
+    (void)pool->trim();
+    EXPECT_EQ(0, pool->get_resident_size());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, FaultCommit, testing::Values(
+                             pool_type::SingleThreaded,
+                             pool_type::ThreadSafe,
+                             pool_type::Locked),
+                         poolTypeParamName);
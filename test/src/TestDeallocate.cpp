@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+using Deallocate = PoolTypeTest;
+
+TEST_P(Deallocate, ReverseOrderFreesEverything) {
+    auto* pool = pool::create(1000, GetParam());
+    std::vector<void*> buffers;
+    for (int i = 0; i < 10; ++i) {
+        buffers.push_back(pool->allocate(100, 1));
+    }
+    assertPoolFull(*pool);
+    for (auto it = buffers.rbegin(); it != buffers.rend(); ++it) {
+        pool->deallocate(*it, 100, 1);
+    }
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(1000, pool->get_peak_size());
+
+    // The whole capacity is usable again.
+    useMemory(pool->new_buffer(1000), 1000);
+    delete pool;
+}
+
+TEST_P(Deallocate, OtherOrderKeepsMemory) {
+    auto* pool = pool::create(1000, GetParam());
+    auto* first = pool->allocate(100, 1);
+    (void)pool->allocate(100, 1);
+    pool->deallocate(first, 100, 1);
+    EXPECT_EQ(200, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Deallocate, FreesPadding) {
+    auto* pool = pool::create(1000, GetParam());
+    auto* first = pool->allocate(3, 1);
+    auto* aligned = pool->allocate(8, 8);
+    EXPECT_NE(0, pool->get_alignment_fragmentation());
+    pool->deallocate(aligned, 8, 8);
+    EXPECT_EQ(3, pool->get_size());
+    EXPECT_EQ(0, pool->get_alignment_fragmentation());
+    pool->deallocate(first, 3, 1);
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(0, pool->get_alignment_fragmentation());
+    delete pool;
+}
+
+TEST_P(Deallocate, AllocatorFreesVectorGrowth) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    {
+        allocator<int> a(pool);
+        std::vector<int, allocator<int>> values(a);
+        values.reserve(100);
+        values.push_back(1);
+    }
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Deallocate, stackPoolTypes, poolTypeParamName);
+
+TEST(Deallocate, ThreadSafeStacksOnManyThreads) {
+    auto* pool = pool::create(1 << 20, pool_type::ThreadSafe);
+    std::vector<std::thread> threads;
+    std::atomic<int> failures = 0;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([pool, &failures] {
+            for (int j = 0; j < 10000; ++j) {
+                auto* buffer = static_cast<int*>(pool->allocate(sizeof(int), alignof(int)));
+                *buffer = j;
+                if (*buffer != j) {
+                    ++failures;
+                }
+                // Reclaimed only if no other thread allocated in between, but never wrongly.
+                pool->deallocate(buffer, sizeof(int), alignof(int));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, failures);
+    EXPECT_LE(pool->get_size(), 4 * 10000 * sizeof(int));
+    delete pool;
+}
+
+TEST(Deallocate, OtherThreadDoesNotGetPool) {
+    auto* pool = pool::create(1000, pool_type::PerThread);
+    auto* buffer = pool->allocate(100, 1);
+    std::thread([pool, buffer] {
+        pool->deallocate(buffer, 100, 1);
+        EXPECT_EQ(1, pool->get_statistics().threads.size());
+    }).join();
+    EXPECT_EQ(100, pool->get_size());
+    delete pool;
+}
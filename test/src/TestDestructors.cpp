@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    pool_options destructorOptions() {
+        pool_options options;
+        options.runDestructors = true;
+        return options;
+    }
+
+    // Records the order objects are destroyed in.
+    struct tracked {
+        std::vector<int>& destroyed;
+        int id;
+
+        tracked(std::vector<int>& destroyed, const int id)
+            : destroyed(destroyed), id(id) {
+        }
+
+        ~tracked() {
+            destroyed.push_back(id);
+        }
+    };
+
+    struct alignas(64) overaligned {
+        int& destroyedCount;
+
+        explicit overaligned(int& destroyedCount)
+            : destroyedCount(destroyedCount) {
+        }
+
+        ~overaligned() {
+            ++destroyedCount;
+        }
+    };
+}
+
+using Destructors = PoolTypeTest;
+
+TEST_P(Destructors, RunInReverseOnDestruction) {
+    std::vector<int> destroyed;
+    auto* pool = pool::create(1 << 20, GetParam(), destructorOptions());
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(i, pool->new_object<tracked>(destroyed, i)->id);
+    }
+    EXPECT_TRUE(destroyed.empty());
+    delete pool;
+    EXPECT_EQ((std::vector{2, 1, 0}), destroyed);
+}
+
+TEST_P(Destructors, RunOnReset) {
+    std::vector<int> destroyed;
+    auto* pool = pool::create(1 << 20, GetParam(), destructorOptions());
+    (void)pool->new_object<tracked>(destroyed, 0);
+    (void)pool->new_object<tracked>(destroyed, 1);
+    pool->reset();
+    EXPECT_EQ((std::vector{1, 0}), destroyed);
+    (void)pool->new_object<tracked>(destroyed, 2);
+    delete pool;
+    EXPECT_EQ((std::vector{1, 0, 2}), destroyed);
+}
+
+TEST_P(Destructors, OverAlignedObject) {
+    int destroyedCount = 0;
+    auto* pool = pool::create(1 << 20, GetParam(), destructorOptions());
+    useMemory(pool->new_buffer(1), 1);
+    auto* object = pool->new_object<overaligned>(destroyedCount);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(object) % 64);
+    delete pool;
+    EXPECT_EQ(1, destroyedCount);
+}
+
+TEST_P(Destructors, OffByDefault) {
+    std::vector<int> destroyed;
+    auto* pool = pool::create(1 << 20, GetParam());
+    (void)pool->new_object<tracked>(destroyed, 0);
+    pool->reset();
+    delete pool;
+    EXPECT_TRUE(destroyed.empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Destructors, allPoolTypes, poolTypeParamName);
+
+using DestructorMarkers = PoolTypeTest;
+
+TEST_P(DestructorMarkers, RewindRunsOnlyNewerDestructors) {
+    std::vector<int> destroyed;
+    auto* pool = pool::create(1 << 20, GetParam(), destructorOptions());
+    (void)pool->new_object<tracked>(destroyed, 0);
+    const auto marker = pool->mark();
+    (void)pool->new_object<tracked>(destroyed, 1);
+    (void)pool->new_object<tracked>(destroyed, 2);
+    pool->rewind(marker);
+    EXPECT_EQ((std::vector{2, 1}), destroyed);
+    delete pool;
+    EXPECT_EQ((std::vector{2, 1, 0}), destroyed);
+}
+
+TEST_P(DestructorMarkers, InvalidMarkerRunsNothing) {
+    std::vector<int> destroyed;
+    auto* pool = pool::create(1 << 20, GetParam(), destructorOptions());
+    (void)pool->new_object<tracked>(destroyed, 0);
+    useMemory(pool->new_buffer(64), 64);
+    const auto marker = pool->mark();
+    pool->reset();
+    (void)pool->new_object<tracked>(destroyed, 1);
+    destroyed.clear();
+    EXPECT_THROW(pool->rewind(marker), std::invalid_argument);
+    EXPECT_TRUE(destroyed.empty());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, DestructorMarkers, stackPoolTypes, poolTypeParamName);
+
+TEST(Destructors, GrowablePool) {
+    std::vector<int> destroyed;
+    auto options = destructorOptions();
+    options.growable = true;
+    auto* pool = pool::create(4096, pool_type::SingleThreaded, options);
+    const auto marker = pool->mark();
+    for (int i = 0; i < 200; ++i) {
+        (void)pool->new_object<tracked>(destroyed, i);
+    }
+    pool->rewind(marker);
+    ASSERT_EQ(200, destroyed.size());
+    EXPECT_EQ(199, destroyed.front());
+    EXPECT_EQ(0, destroyed.back());
+    delete pool;
+}
+
+TEST(Destructors, ThreadSafeFromManyThreads) {
+    std::atomic<int> destroyedCount = 0;
+    struct counter {
+        std::atomic<int>& count;
+
+        ~counter() {
+            ++count;
+        }
+    };
+    auto* pool = pool::create(1 << 20, pool_type::ThreadSafe, destructorOptions());
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 1000; ++j) {
+                (void)pool->new_object<counter>(destroyedCount);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    delete pool;
+    EXPECT_EQ(4000, destroyedCount);
+}
+
+TEST(Destructors, ConstructorThrows) {
+    struct throwing {
+        throwing() {
+            throw std::runtime_error("Failed");
+        }
+
+        ~throwing() {
+            ADD_FAILURE() << "Destroyed an object that was never constructed";
+        }
+    };
+    auto* pool = pool::create(1000, pool_type::SingleThreaded, destructorOptions());
+    EXPECT_THROW((void)pool->new_object<throwing>(), std::runtime_error);
+    delete pool;
+}
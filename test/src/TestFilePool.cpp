@@ -0,0 +1,217 @@
+#include "gtest/gtest.h"
+#include "memory-pool/file_pool.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    struct node {
+        int value;
+        size_t nextOffset; // 0 for none. Tests keep nodes off the pool's first byte.
+        node* next;
+    };
+
+    file_pool_options fixedOptions() {
+        file_pool_options options;
+        options.mapping = file_mapping::Fixed;
+        return options;
+    }
+}
+
+class FilePool : public testing::Test {
+protected:
+    std::filesystem::path path;
+
+    void SetUp() override {
+        static std::atomic<int> counter = 0;
+        path = std::filesystem::temp_directory_path() /
+               ("memory_pool_test_" + std::to_string(getpid()) + "_" + std::to_string(counter++) + ".pool");
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST_F(FilePool, CreatesFile) {
+    auto* pool = file_pool::open(path, 10 * MB + 3);
+    EXPECT_TRUE(pool->is_new());
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_EQ(10 * MB + 3, pool->get_capacity());
+    EXPECT_EQ(nullptr, pool->get_root());
+    useMemory(pool->new_buffer(10 * MB + 3), 10 * MB + 3);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_F(FilePool, ReopensWithData) {
+    auto* pool = file_pool::open(path, MB);
+    (void)pool->new_buffer(100, 64);
+    auto* message = static_cast<char*>(pool->new_buffer(6));
+    std::copy_n("hello", 6, message);
+    pool->set_root(message);
+    const auto size = pool->get_size();
+    const auto fragmentation = pool->get_alignment_fragmentation();
+    delete pool;
+
+    // The capacity given when reopening doesn't matter.
+    pool = file_pool::open(path, 1);
+    EXPECT_FALSE(pool->is_new());
+    EXPECT_EQ(MB, pool->get_capacity());
+    EXPECT_EQ(size, pool->get_size());
+    EXPECT_EQ(fragmentation, pool->get_alignment_fragmentation());
+    ASSERT_NE(nullptr, pool->get_root());
+    EXPECT_STREQ("hello", static_cast<char*>(pool->get_root()));
+
+    // Allocation carries on after the existing data.
+    auto* next = static_cast<char*>(pool->new_buffer(1));
+    EXPECT_EQ(size, pool->to_offset(next));
+    delete pool;
+}
+
+TEST_F(FilePool, OffsetsSurviveRelocation) {
+    auto* pool = file_pool::open(path, MB);
+    (void)pool->new_buffer(1);
+    node* head = nullptr;
+    for (int i = 0; i < 100; ++i) {
+        auto* item = pool->new_object<node>(i, head == nullptr ? 0 : pool->to_offset(head), nullptr);
+        head = item;
+    }
+    pool->set_root(head);
+    delete pool;
+
+    pool = file_pool::open(path, MB);
+    int expected = 99;
+    for (auto* item = static_cast<node*>(pool->get_root()); item != nullptr;
+         item = item->nextOffset == 0 ? nullptr : static_cast<node*>(pool->from_offset(item->nextOffset))) {
+        EXPECT_EQ(expected--, item->value);
+    }
+    EXPECT_EQ(-1, expected);
+    delete pool;
+}
+
+TEST_F(FilePool, FixedMappingKeepsPointers) {
+    auto* pool = file_pool::open(path, MB, fixedOptions());
+    node* head = nullptr;
+    for (int i = 0; i < 100; ++i) {
+        head = pool->new_object<node>(i, 0, head);
+    }
+    pool->set_root(head);
+    delete pool;
+
+    pool = file_pool::open(path, MB, fixedOptions());
+    EXPECT_EQ(head, pool->get_root());
+    int expected = 99;
+    for (auto* item = static_cast<node*>(pool->get_root()); item != nullptr; item = item->next) {
+        EXPECT_EQ(expected--, item->value);
+    }
+    EXPECT_EQ(-1, expected);
+    delete pool;
+}
+
+TEST_F(FilePool, FixedMappingFailsWhenAddressTaken) {
+    auto* pool = file_pool::open(path, MB, fixedOptions());
+    (void)pool->new_buffer(1);
+    // The pool itself is mapped at its address, so another mapping of it can't go there.
+    EXPECT_THROW((void)file_pool::open(path, MB, fixedOptions()), std::system_error);
+    auto* relocated = file_pool::open(path, MB);
+    EXPECT_EQ(1, relocated->get_size());
+    delete relocated;
+    delete pool;
+}
+
+TEST_F(FilePool, RewindPersists) {
+    auto* pool = file_pool::open(path, MB);
+    (void)pool->new_buffer(1000);
+    const auto marker = pool->mark();
+    (void)pool->new_buffer(5000);
+    pool->rewind(marker);
+    delete pool;
+
+    pool = file_pool::open(path, MB);
+    EXPECT_EQ(1000, pool->get_size());
+    EXPECT_EQ(6000, pool->get_peak_size());
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+TEST_F(FilePool, SyncWritesToFile) {
+    auto* pool = file_pool::open(path, MB);
+    const std::string message = "written through the pool";
+    auto* buffer = static_cast<char*>(pool->new_buffer(message.size()));
+    std::copy(message.begin(), message.end(), buffer);
+    pool->sync();
+
+    std::ifstream file(path, std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(std::string::npos, contents.find(message));
+    delete pool;
+}
+
+TEST_F(FilePool, RejectsOtherFiles) {
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(8192, 'x');
+    }
+    EXPECT_THROW((void)file_pool::open(path, MB), std::invalid_argument);
+}
+
+TEST_F(FilePool, EmptyFileStartsOver) {
+    std::ofstream(path, std::ios::binary).close();
+    auto* pool = file_pool::open(path, MB);
+    EXPECT_TRUE(pool->is_new());
+    EXPECT_EQ(MB, pool->get_capacity());
+    delete pool;
+}
+
+TEST_F(FilePool, ConcurrentOpensCreateOnce) {
+    std::vector<file_pool*> pools(8);
+    std::vector<std::thread> threads;
+    for (auto& pool : pools) {
+        threads.emplace_back([this, &pool] { pool = file_pool::open(path, MB); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(1, std::ranges::count_if(pools, [](const file_pool* pool) { return pool->is_new(); }));
+    for (auto* pool : pools) {
+        EXPECT_EQ(MB, pool->get_capacity());
+        delete pool;
+    }
+}
+
+TEST_F(FilePool, ThreadsShareFile) {
+    auto* pool = file_pool::open(path, 8 * MB);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([pool] {
+            for (int j = 0; j < 1000; ++j) {
+                useMemory(pool->new_buffer(1000), 1000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(4 * 1000 * 1000, pool->get_size());
+    delete pool;
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t KB = 1024;
+
+    pool_options growableOptions(const size_t maxCapacity = 0) {
+        pool_options options;
+        options.growable = true;
+        options.maxCapacity = maxCapacity;
+        return options;
+    }
+}
+
+using Growth = PoolTypeTest;
+
+TEST_P(Growth, GrowsPastInitialCapacity) {
+    auto* pool = pool::create(64 * KB, GetParam(), growableOptions());
+    for (int i = 0; i < 1000; ++i) {
+        useMemory(pool->new_buffer(KB), KB);
+    }
+    EXPECT_GT(pool->get_capacity(), 64 * KB);
+    EXPECT_EQ(1000 * KB, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Growth, SegmentsDouble) {
+    auto* pool = pool::create(64 * KB, GetParam(), growableOptions());
+    useMemory(pool->new_buffer(64 * KB), 64 * KB);
+    EXPECT_EQ(64 * KB, pool->get_capacity());
+    useMemory(pool->new_buffer(1), 1);
+    EXPECT_EQ(192 * KB, pool->get_capacity());
+    delete pool;
+}
+
+TEST_P(Growth, FitsLargeRequest) {
+    auto* pool = pool::create(4 * KB, GetParam(), growableOptions());
+    useMemory(pool->new_buffer(KB), KB);
+    useMemory(pool->new_buffer(100 * KB, 64), 100 * KB);
+    EXPECT_EQ(101 * KB, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Growth, StopsAtMaxCapacity) {
+    auto* pool = pool::create(64 * KB, GetParam(), growableOptions(256 * KB));
+    EXPECT_THROW({
+        for (;;)
+            useMemory(pool->new_buffer(KB), KB);
+    }, std::invalid_argument);
+    EXPECT_EQ(256 * KB, pool->get_capacity());
+    EXPECT_EQ(256 * KB, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Growth, RewindFreesLaterSegments) {
+    auto* pool = pool::create(64 * KB, GetParam(), growableOptions());
+    useMemory(pool->new_buffer(10), 10);
+    const auto marker = pool->mark();
+    for (int i = 0; i < 1000; ++i) {
+        useMemory(pool->new_buffer(KB, 8), KB);
+    }
+    pool->rewind(marker);
+    EXPECT_EQ(64 * KB, pool->get_capacity());
+    EXPECT_EQ(10, pool->get_size());
+    EXPECT_EQ(0, pool->get_alignment_fragmentation());
+
+    for (int i = 0; i < 1000; ++i) {
+        useMemory(pool->new_buffer(KB, 8), KB);
+    }
+    const auto laterMarker = pool->mark();
+    const auto size = pool->get_size();
+    const auto capacity = pool->get_capacity();
+    for (int i = 0; i < 1000; ++i) {
+        useMemory(pool->new_buffer(KB, 8), KB);
+    }
+    pool->rewind(laterMarker);
+    EXPECT_EQ(size, pool->get_size());
+    EXPECT_EQ(capacity, pool->get_capacity());
+
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(64 * KB, pool->get_capacity());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Growth, testing::Values(
+                             pool_type::SingleThreaded,
+                             pool_type::ThreadSafe,
+                             pool_type::PerThread),
+                         poolTypeParamName);
+
+TEST(Growth, ConcurrentGrowth) {
+    auto* pool = pool::create(4 * KB, pool_type::ThreadSafe, growableOptions());
+    constexpr int threadCount = 8;
+    constexpr int allocationsPerThread = 20000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([pool] {
+            for (int j = 0; j < allocationsPerThread; ++j) {
+                useMemory(pool->new_buffer(64), 64);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(threadCount * allocationsPerThread * 64, pool->get_size());
+    delete pool;
+}
+
+TEST(Growth, UnsupportedTypeThrows) {
+    EXPECT_THROW((void)pool::create(KB, pool_type::Locked, growableOptions()), std::invalid_argument);
+}
+
+TEST(Growth, MaxCapacityBelowCapacityThrows) {
+    EXPECT_THROW((void)pool::create(2 * KB, pool_type::SingleThreaded, growableOptions(KB)), std::invalid_argument);
+}
@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+    constexpr size_t hugePageSize = 2 * MB;
+
+    struct huge_pool_param {
+        pool_type type;
+        huge_pages hugePages;
+    };
+
+    std::string paramName(const testing::TestParamInfo<huge_pool_param>& info) {
+        return std::string(poolTypeName(info.param.type)) +
+               (info.param.hugePages == huge_pages::Explicit ? "Explicit" : "Transparent");
+    }
+}
+
+class HugePages : public testing::TestWithParam<huge_pool_param> {
+protected:
+    [[nodiscard]] pool* createPool(const size_t capacity) const {
+        pool_options options;
+        options.hugePages = GetParam().hugePages;
+        return pool::create(capacity, GetParam().type, options);
+    }
+};
+
+TEST_P(HugePages, ReservationIsHugePageAligned) {
+    auto* pool = createPool(64 * MB);
+    const auto first = reinterpret_cast<uintptr_t>(pool->new_buffer(1));
+    EXPECT_EQ(0, first % hugePageSize);
+    delete pool;
+}
+
+TEST_P(HugePages, CommitsWholeHugePages) {
+    auto* pool = createPool(64 * MB + 1);
+    useMemory(pool->new_buffer(5 * MB), 5 * MB);
+    EXPECT_EQ(0, pool->get_committed_size() % hugePageSize);
+    EXPECT_GE(pool->get_committed_size(), 5 * MB);
+    delete pool;
+}
+
+TEST_P(HugePages, FillsOddCapacity) {
+    constexpr auto size = 3 * MB + 123;
+    auto* pool = createPool(size);
+    useMemory(pool->new_buffer(size), size);
+    assertPoolFull(*pool);
+    pool->reset();
+    EXPECT_GT(pool->trim(), 0);
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, HugePages, testing::Values(
+                             huge_pool_param{pool_type::SingleThreaded, huge_pages::Transparent},
+                             huge_pool_param{pool_type::SingleThreaded, huge_pages::Explicit},
+                             huge_pool_param{pool_type::ThreadSafe, huge_pages::Transparent},
+                             huge_pool_param{pool_type::ThreadSafe, huge_pages::Explicit}),
+                         paramName);
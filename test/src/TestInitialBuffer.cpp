@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    bool isIn(const void* p, const char* buffer, const size_t size) {
+        return p >= buffer && p < buffer + size;
+    }
+}
+
+using InitialBuffer = PoolTypeTest;
+
+TEST_P(InitialBuffer, ServesFromBufferFirst) {
+    alignas(16) char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    auto* first = pool->new_buffer(100);
+    auto* second = pool->new_buffer(100, 16);
+    EXPECT_TRUE(isIn(first, buffer, sizeof(buffer)));
+    EXPECT_TRUE(isIn(second, buffer, sizeof(buffer)));
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(second) % 16);
+    EXPECT_EQ(212, pool->get_size());
+    EXPECT_EQ(12, pool->get_alignment_fragmentation());
+    EXPECT_EQ(sizeof(buffer), pool->get_committed_size());
+    EXPECT_EQ(0, pool->get_resident_size());
+    EXPECT_EQ(1 << 20, pool->get_capacity());
+    delete pool;
+}
+
+TEST_P(InitialBuffer, SpillsWhenFull) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    useMemory(pool->new_buffer(200), 200);
+    auto* spilled = pool->new_buffer(100);
+    EXPECT_FALSE(isIn(spilled, buffer, sizeof(buffer)));
+    useMemory(spilled, 100);
+    // Once spilled, even small allocations come from the backing pool.
+    EXPECT_FALSE(isIn(pool->new_buffer(1), buffer, sizeof(buffer)));
+    EXPECT_EQ(301, pool->get_size());
+    EXPECT_GT(pool->get_committed_size(), sizeof(buffer));
+    delete pool;
+}
+
+TEST_P(InitialBuffer, ResetReusesBuffer) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    useMemory(pool->new_buffer(200), 200);
+    useMemory(pool->new_buffer(1000), 1000);
+    EXPECT_EQ(1200, pool->get_peak_size());
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_TRUE(isIn(pool->new_buffer(10), buffer, sizeof(buffer)));
+    EXPECT_EQ(1200, pool->get_peak_size());
+    delete pool;
+}
+
+TEST_P(InitialBuffer, MarkersSpanBufferAndBackingPool) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    useMemory(pool->new_buffer(100), 100);
+    const auto inBuffer = pool->mark();
+    useMemory(pool->new_buffer(200), 200);
+    const auto inBacking = pool->mark();
+    useMemory(pool->new_buffer(300), 300);
+    pool->rewind(inBacking);
+    EXPECT_EQ(300, pool->get_size());
+    pool->rewind(inBuffer);
+    EXPECT_EQ(100, pool->get_size());
+    EXPECT_TRUE(isIn(pool->new_buffer(100), buffer, sizeof(buffer)));
+    delete pool;
+}
+
+TEST_P(InitialBuffer, BufferIsWholePool) {
+    char buffer[256];
+    auto* pool = pool::create(100, GetParam(), {}, buffer, sizeof(buffer));
+    EXPECT_EQ(100, pool->get_capacity());
+    useMemory(pool->new_buffer(100), 100);
+    assertPoolFull(*pool);
+    EXPECT_THROW((void)pool->new_buffer(1), std::invalid_argument);
+    delete pool;
+}
+
+TEST_P(InitialBuffer, OutOfMemory) {
+    char buffer[256];
+    auto* pool = pool::create(1000, GetParam(), {}, buffer, sizeof(buffer));
+    useMemory(pool->new_buffer(200), 200);
+    useMemory(pool->new_buffer(744), 744);
+    EXPECT_THROW((void)pool->new_buffer(100), std::invalid_argument);
+    delete pool;
+}
+
+TEST_P(InitialBuffer, ResizesInBufferAndBackingPool) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    auto* inBuffer = pool->new_buffer(100, 1);
+    EXPECT_TRUE(pool->try_extend(inBuffer, 100, 200));
+    EXPECT_FALSE(pool->try_extend(inBuffer, 200, 300));
+    EXPECT_TRUE(pool->shrink(inBuffer, 200, 150));
+    EXPECT_EQ(150, pool->get_size());
+    auto* inBacking = pool->new_buffer(200, 1);
+    EXPECT_FALSE(isIn(inBacking, buffer, sizeof(buffer)));
+    EXPECT_TRUE(pool->try_extend(inBacking, 200, 1000));
+    EXPECT_EQ(1150, pool->get_size());
+    EXPECT_TRUE(pool->shrink(inBacking, 1000, 100));
+    EXPECT_EQ(250, pool->get_size());
+    EXPECT_EQ(1150, pool->get_peak_size());
+    delete pool;
+}
+
+TEST_P(InitialBuffer, ReverseOrderFreesEverything) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    auto* first = pool->allocate(100, 1);
+    auto* second = pool->allocate(100, 1);
+    pool->deallocate(second, 100, 1);
+    pool->deallocate(first, 100, 1);
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(200, pool->get_peak_size());
+    delete pool;
+}
+
+TEST_P(InitialBuffer, ChildGivesSpaceBack) {
+    char buffer[256];
+    auto* pool = pool::create(1 << 20, GetParam(), {}, buffer, sizeof(buffer));
+    useMemory(pool->new_buffer(16), 16);
+    auto* child = pool->create_child(1000);
+    useMemory(child->new_buffer(100), 100);
+    EXPECT_EQ(116, pool->get_size());
+    delete child;
+    EXPECT_EQ(16, pool->get_size());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, InitialBuffer, testing::Values(
+                             pool_type::SingleThreaded,
+                             pool_type::ThreadSafe),
+                         poolTypeParamName);
+
+TEST(InitialBuffer, UnsupportedTypes) {
+    char buffer[256];
+    EXPECT_THROW((void)pool::create(1000, pool_type::PerThread, {}, buffer, sizeof(buffer)), std::invalid_argument);
+    pool_options options;
+    options.growable = true;
+    EXPECT_THROW((void)pool::create(1000, pool_type::SingleThreaded, options, buffer, sizeof(buffer)),
+                 std::invalid_argument);
+}
+
+TEST(InitialBuffer, ThreadsSpillTogether) {
+    char buffer[4096];
+    auto* pool = pool::create(1 << 24, pool_type::ThreadSafe, {}, buffer, sizeof(buffer));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([pool] {
+            for (int j = 0; j < 1000; ++j) {
+                useMemory(pool->new_buffer(16), 16);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(4 * 1000 * 16, pool->get_size());
+    delete pool;
+}
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+class Metrics : public PoolTypeTest {
+protected:
+    void SetUp() override {
+        if (!pool::get_metrics().enabled) {
+            GTEST_SKIP() << "Built without MEMORY_POOL_METRICS";
+        }
+    }
+};
+
+TEST_P(Metrics, CountsEachAllocationOnce) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    const auto before = pool::get_metrics();
+    useMemory(pool->new_buffer(100), 100);
+    useMemory(pool->new_buffer(3, 1), 3);
+    useMemory(pool->new_buffer(64, 64), 64);
+    const auto after = pool::get_metrics();
+    EXPECT_EQ(3, after.allocations - before.allocations);
+    EXPECT_EQ(167, after.allocatedBytes - before.allocatedBytes);
+    // 100 is in [64, 128), 3 in [2, 4) and 64 in [64, 128).
+    EXPECT_EQ(2, after.sizeHistogram[7] - before.sizeHistogram[7]);
+    EXPECT_EQ(1, after.sizeHistogram[2] - before.sizeHistogram[2]);
+    EXPECT_EQ(2, after.alignmentHistogram[0] - before.alignmentHistogram[0]);
+    EXPECT_EQ(1, after.alignmentHistogram[6] - before.alignmentHistogram[6]);
+    delete pool;
+}
+
+TEST_P(Metrics, CountsDeallocations) {
+    auto* pool = pool::create(1 << 20, GetParam());
+    auto* p = pool->allocate(32, 8);
+    const auto before = pool::get_metrics();
+    pool->deallocate(p, 32, 8);
+    EXPECT_EQ(1, pool::get_metrics().deallocations - before.deallocations);
+    delete pool;
+}
+
+TEST_P(Metrics, CountsCommits) {
+    const auto before = pool::get_metrics();
+    auto* pool = pool::create(1 << 20, GetParam());
+    useMemory(pool->new_buffer(1 << 19), 1 << 19);
+    const auto after = pool::get_metrics();
+    EXPECT_GT(after.commits, before.commits);
+    EXPECT_GE(after.commitNanoseconds, before.commitNanoseconds);
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Metrics, allPoolTypes, poolTypeParamName);
+
+TEST(Metrics, IncludesExitedThreads) {
+    if (!pool::get_metrics().enabled) {
+        GTEST_SKIP() << "Built without MEMORY_POOL_METRICS";
+    }
+    auto* pool = pool::create(1 << 20, pool_type::ThreadSafe);
+    const auto before = pool::get_metrics();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([pool] {
+            for (int j = 0; j < 10; ++j) {
+                useMemory(pool->new_buffer(16), 16);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(40, pool::get_metrics().allocations - before.allocations);
+    delete pool;
+}
+
+TEST(Metrics, CountsLockWaits) {
+    if (!pool::get_metrics().enabled) {
+        GTEST_SKIP() << "Built without MEMORY_POOL_METRICS";
+    }
+    auto* pool = pool::create(1 << 24, pool_type::Locked);
+    const auto before = pool::get_metrics();
+    std::atomic<bool> go = false;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            for (int j = 0; j < 10000; ++j) {
+                useMemory(pool->new_buffer(8), 8);
+            }
+        });
+    }
+    go = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto after = pool::get_metrics();
+    EXPECT_LE(after.lockWaits - before.lockWaits, 40000);
+    EXPECT_GE(after.lockWaitNanoseconds, before.lockWaitNanoseconds);
+    delete pool;
+}
+
+TEST(Metrics, DisabledBuildReportsNothing) {
+    const auto metrics = pool::get_metrics();
+    if (metrics.enabled) {
+        GTEST_SKIP() << "Built with MEMORY_POOL_METRICS";
+    }
+    EXPECT_EQ(0, metrics.allocations);
+    EXPECT_EQ(0, metrics.commits);
+}
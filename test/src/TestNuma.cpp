@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    pool_options numaOptions(const numa_policy policy) {
+        pool_options options;
+        options.numaPolicy = policy;
+        return options;
+    }
+
+    // Fills part of the pool, which would crash if a policy broke the reservation.
+    void fill(pool& pool) {
+        for (int i = 0; i < 64; ++i) {
+            useMemory(pool.new_buffer(64 * 1024, 64), 64 * 1024);
+        }
+    }
+}
+
+using Numa = PoolTypeTest;
+
+TEST_P(Numa, DefaultIsNotBound) {
+    auto* pool = pool::create(16 * MB, GetParam());
+    fill(*pool);
+    EXPECT_EQ(-1, pool->get_numa_node());
+    delete pool;
+}
+
+TEST_P(Numa, LocalBindsToOneNode) {
+    auto* pool = pool::create(16 * MB, GetParam(), numaOptions(numa_policy::Local));
+    fill(*pool);
+    // -1 if the kernel doesn't allow binding here.
+    EXPECT_GE(pool->get_numa_node(), -1);
+    delete pool;
+}
+
+TEST_P(Numa, InterleaveIsNotBoundToOneNode) {
+    auto* pool = pool::create(16 * MB, GetParam(), numaOptions(numa_policy::Interleave));
+    fill(*pool);
+    EXPECT_EQ(-1, pool->get_numa_node());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Numa, allPoolTypes, poolTypeParamName);
+
+TEST(Numa, PerThreadPoolsBindOnTheirOwnThreads) {
+    auto* pool = pool::create(16 * MB, pool_type::PerThread, numaOptions(numa_policy::Local));
+    std::vector<std::thread> threads;
+    std::vector<int> nodes(4);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        threads.emplace_back([pool, &nodes, i] {
+            fill(*pool);
+            nodes[i] = pool->get_numa_node();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto node : nodes) {
+        EXPECT_GE(node, -1);
+    }
+    delete pool;
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    // Leaking this many reservations of this size would take more address space than a process has.
+    constexpr size_t hugeCapacity = static_cast<size_t>(1) << 36;
+    constexpr int reservationCount = 4096;
+}
+
+TEST(PerThread, EachThreadHasItsOwnPool) {
+    auto* pool = pool::create(1000, pool_type::PerThread);
+    useMemory(pool->new_buffer(100), 100);
+    std::thread([pool] {
+        EXPECT_EQ(0, pool->get_size());
+        useMemory(pool->new_buffer(1000), 1000);
+        assertPoolFull(*pool);
+    }).join();
+    EXPECT_EQ(100, pool->get_size());
+    delete pool;
+}
+
+TEST(PerThread, NewPoolDoesNotInheritThreadState) {
+    for (int i = 0; i < 100; ++i) {
+        auto* pool = pool::create(1000, pool_type::PerThread);
+        EXPECT_EQ(0, pool->get_size());
+        useMemory(pool->new_buffer(10), 10);
+        delete pool;
+    }
+}
+
+TEST(PerThread, DestroyingPoolFreesThreadPools) {
+    for (int i = 0; i < reservationCount; ++i) {
+        auto* pool = pool::create(hugeCapacity, pool_type::PerThread);
+        useMemory(pool->new_buffer(10), 10);
+        delete pool;
+    }
+}
+
+TEST(PerThread, ThreadExitFreesItsPool) {
+    auto* pool = pool::create(hugeCapacity, pool_type::PerThread);
+    for (int i = 0; i < reservationCount; ++i) {
+        std::thread([pool] {
+            useMemory(pool->new_buffer(10), 10);
+        }).join();
+    }
+    delete pool;
+}
+
+TEST(PerThread, PoolDestroyedWhileThreadsRun) {
+    auto* pool = pool::create(1000, pool_type::PerThread);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready = 0;
+    std::atomic<bool> destroyed = false;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            useMemory(pool->new_buffer(10), 10);
+            ++ready;
+            while (!destroyed) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (ready < 4) {
+        std::this_thread::yield();
+    }
+    delete pool;
+    destroyed = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <map>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+}
+
+TEST(Recycling, ReusesDeallocatedBlock) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    auto* first = pool->allocate(100, 8);
+    pool->deallocate(first, 100, 8);
+    // Same size class.
+    auto* second = pool->allocate(120, 8);
+    EXPECT_EQ(first, second);
+    delete pool;
+}
+
+TEST(Recycling, BlocksAreAlignedToTheirSizeClass) {
+    auto* pool = pool::create(16 * MB, pool_type::Recycling);
+    for (size_t size = 16; size <= MB; size *= 2) {
+        auto* buffer = pool->allocate(size - 1, 1);
+        useMemory(buffer, size - 1);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buffer) % std::min<size_t>(size, 4096)) << size;
+    }
+    delete pool;
+}
+
+TEST(Recycling, SizeExcludesFreedBlocks) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    std::vector<void*> buffers;
+    for (int i = 0; i < 100; ++i) {
+        buffers.push_back(pool->allocate(64, 8));
+    }
+    EXPECT_EQ(100 * 64, pool->get_size());
+    for (auto* buffer : buffers) {
+        pool->deallocate(buffer, 64, 8);
+    }
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+TEST(Recycling, ChurnStaysWithinCapacity) {
+    // Without reuse, this churn would need far more than the capacity.
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    {
+        std::pmr::map<int, std::pmr::vector<char>> map(pool);
+        for (int i = 0; i < 200000; ++i) {
+            map.try_emplace(i % 512, std::pmr::vector<char>(i % 200, 'x', pool));
+            if (i % 3 == 0) {
+                map.erase((i * 7) % 512);
+            }
+        }
+        EXPECT_LT(pool->get_size(), pool->get_capacity());
+    }
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+TEST(Recycling, LargeRequestsAreNotReused) {
+    auto* pool = pool::create(8 * MB, pool_type::Recycling);
+    auto* first = pool->allocate(2 * MB, 8);
+    pool->deallocate(first, 2 * MB, 8);
+    auto* second = pool->allocate(2 * MB, 8);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(4 * MB, pool->get_size());
+    delete pool;
+}
+
+TEST(Recycling, AlignmentNotPowerOf2) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    for (int i = 0; i < 100; ++i) {
+        auto* buffer = pool->allocate(24, 24);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buffer) % 24);
+        useMemory(buffer, 24);
+        pool->deallocate(buffer, 24, 24);
+    }
+    delete pool;
+}
+
+TEST(Recycling, BlocksFreedOnAnotherThreadAreReused) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    constexpr int count = 10000;
+    std::vector<void*> buffers(count);
+    std::thread([&] {
+        for (auto& buffer : buffers) {
+            buffer = pool->allocate(32, 8);
+        }
+    }).join();
+    const auto sizeAfterAllocating = pool->get_size();
+    EXPECT_EQ(count * 32, sizeAfterAllocating);
+    for (auto* buffer : buffers) {
+        pool->deallocate(buffer, 32, 8);
+    }
+    EXPECT_EQ(0, pool->get_size());
+    // An exiting thread gives back its cached blocks, so these need no new memory.
+    std::thread([&] {
+        for (auto& buffer : buffers) {
+            buffer = pool->allocate(32, 8);
+        }
+    }).join();
+    EXPECT_EQ(count * 32, pool->get_size());
+    delete pool;
+}
+
+TEST(Recycling, FreedByThreadWithoutCacheIsReused) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    void* buffer = nullptr;
+    std::thread([&] {
+        buffer = pool->allocate(64, 8);
+    }).join();
+    // This thread has never allocated, so the block goes straight to the shared list.
+    pool->deallocate(buffer, 64, 8);
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(buffer, pool->allocate(64, 8));
+    delete pool;
+}
+
+TEST(Recycling, ManyThreadsChurn) {
+    auto* pool = pool::create(64 * MB, pool_type::Recycling);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([pool, t] {
+            std::vector<std::pair<void*, size_t>> live;
+            for (int i = 0; i < 50000; ++i) {
+                const size_t size = 8 + (i * 37 + t) % 3000;
+                auto* buffer = pool->allocate(size, 8);
+                useMemory(buffer, size);
+                live.emplace_back(buffer, size);
+                if (live.size() > 64) {
+                    pool->deallocate(live.front().first, live.front().second, 8);
+                    live.erase(live.begin());
+                }
+            }
+            for (const auto& [buffer, size] : live) {
+                pool->deallocate(buffer, size, 8);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, pool->get_size());
+    delete pool;
+}
+
+TEST(Recycling, PoolDestroyedBeforeThreadExits) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    std::thread thread([&] {
+        (void)pool->allocate(64, 8);
+        delete pool;
+    });
+    thread.join();
+}
+
+TEST(Recycling, Reset) {
+    auto* pool = pool::create(MB, pool_type::Recycling);
+    auto* first = pool->allocate(64, 8);
+    pool->deallocate(first, 64, 8);
+    (void)pool->allocate(MB / 2, 8);
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    usePool(*pool, 4096);
+    assertPoolFull(*pool);
+    delete pool;
+}
@@ -0,0 +1,178 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    reservation_cache_options cacheOptions(const size_t maxReservations, const size_t maxBytes = 0,
+                                           const bool keepWarm = false) {
+        reservation_cache_options options;
+        options.maxReservations = maxReservations;
+        options.maxBytes = maxBytes;
+        options.keepWarm = keepWarm;
+        return options;
+    }
+}
+
+// The cache is process-wide, so each test turns it off again, freeing what it holds.
+class ReservationCache : public testing::Test {
+protected:
+    void TearDown() override {
+        pool::configure_reservation_cache({});
+        EXPECT_EQ(0, pool::get_reservation_cache_statistics().reservations);
+    }
+};
+
+TEST_F(ReservationCache, OffByDefault) {
+    const auto before = pool::get_reservation_cache_statistics();
+    delete pool::create(MB, pool_type::SingleThreaded);
+    delete pool::create(MB, pool_type::SingleThreaded);
+    const auto after = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(before.hits, after.hits);
+    EXPECT_EQ(before.misses, after.misses);
+    EXPECT_EQ(0, after.reservations);
+}
+
+TEST_F(ReservationCache, ReusesReservationOfSameSize) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    const auto before = pool::get_reservation_cache_statistics();
+    auto* pool = pool::create(3 * MB, pool_type::SingleThreaded);
+    useMemory(pool->new_buffer(2 * MB), 2 * MB);
+    auto* buffer = pool->new_buffer(1);
+    delete pool;
+    EXPECT_EQ(1, pool::get_reservation_cache_statistics().reservations);
+
+    pool = pool::create(3 * MB, pool_type::ThreadSafe);
+    useMemory(pool->new_buffer(2 * MB), 2 * MB);
+    EXPECT_EQ(buffer, pool->new_buffer(1));
+    const auto after = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(before.hits + 1, after.hits);
+    EXPECT_EQ(before.misses + 1, after.misses);
+    EXPECT_EQ(0, after.reservations);
+    delete pool;
+}
+
+TEST_F(ReservationCache, KeepsCommittedPages) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    auto* pool = pool::create(64 * MB, pool_type::SingleThreaded);
+    useMemory(pool->new_buffer(20 * MB), 20 * MB);
+    const auto committed = pool->get_committed_size();
+    delete pool;
+
+    pool = pool::create(64 * MB, pool_type::SingleThreaded);
+    EXPECT_EQ(committed, pool->get_committed_size());
+    EXPECT_EQ(0, pool->get_size());
+    useMemory(pool->new_buffer(64 * MB), 64 * MB);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_F(ReservationCache, ReleasesPagesUnlessKeptWarm) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    auto* pool = pool::create(8 * MB, pool_type::SingleThreaded);
+    useMemory(pool->new_buffer(4 * MB), 4 * MB);
+    delete pool;
+    pool = pool::create(8 * MB, pool_type::SingleThreaded);
+    EXPECT_EQ(0, pool->get_resident_size());
+    useMemory(pool->new_buffer(4 * MB), 4 * MB);
+    delete pool;
+
+    pool::configure_reservation_cache(cacheOptions(4, 0, true));
+    pool = pool::create(8 * MB, pool_type::SingleThreaded);
+    useMemory(pool->new_buffer(4 * MB), 4 * MB);
+    delete pool;
+    pool = pool::create(8 * MB, pool_type::SingleThreaded);
+    EXPECT_GE(pool->get_resident_size(), 4 * MB);
+    delete pool;
+}
+
+TEST_F(ReservationCache, DoesNotMatchOtherSizesOrModes) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    delete pool::create(5 * MB, pool_type::SingleThreaded);
+    const auto before = pool::get_reservation_cache_statistics();
+
+    pool_options faultOptions;
+    faultOptions.commitMode = commit_mode::Fault;
+    auto* otherMode = pool::create(5 * MB, pool_type::SingleThreaded, faultOptions);
+    auto* otherSize = pool::create(6 * MB, pool_type::SingleThreaded);
+    const auto after = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(before.hits, after.hits);
+    EXPECT_EQ(before.misses + 2, after.misses);
+    EXPECT_EQ(1, after.reservations);
+    delete otherMode;
+    delete otherSize;
+}
+
+TEST_F(ReservationCache, EvictsOldestBeyondCount) {
+    pool::configure_reservation_cache(cacheOptions(2));
+    const auto before = pool::get_reservation_cache_statistics();
+    auto* first = pool::create(MB, pool_type::SingleThreaded);
+    auto* second = pool::create(2 * MB, pool_type::SingleThreaded);
+    auto* third = pool::create(3 * MB, pool_type::SingleThreaded);
+    delete first;
+    delete second;
+    delete third;
+    auto after = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(2, after.reservations);
+    EXPECT_EQ(5 * MB, after.bytes);
+    EXPECT_EQ(before.evictions + 1, after.evictions);
+
+    // The 1 MB reservation was evicted.
+    delete pool::create(MB, pool_type::SingleThreaded);
+    EXPECT_EQ(after.hits, pool::get_reservation_cache_statistics().hits);
+}
+
+TEST_F(ReservationCache, EvictsOldestBeyondBytes) {
+    pool::configure_reservation_cache(cacheOptions(16, 4 * MB));
+    delete pool::create(2 * MB, pool_type::SingleThreaded);
+    delete pool::create(3 * MB, pool_type::SingleThreaded);
+    auto stats = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(1, stats.reservations);
+    EXPECT_EQ(3 * MB, stats.bytes);
+
+    // Too big to cache at all.
+    delete pool::create(5 * MB, pool_type::SingleThreaded);
+    stats = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(1, stats.reservations);
+    EXPECT_EQ(3 * MB, stats.bytes);
+}
+
+TEST_F(ReservationCache, ShrinkingLimitsFreesReservations) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    delete pool::create(MB, pool_type::SingleThreaded);
+    delete pool::create(2 * MB, pool_type::SingleThreaded);
+    EXPECT_EQ(2, pool::get_reservation_cache_statistics().reservations);
+    pool::configure_reservation_cache(cacheOptions(1));
+    const auto stats = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(1, stats.reservations);
+    EXPECT_EQ(2 * MB, stats.bytes);
+}
+
+TEST_F(ReservationCache, NumaPoolsBypassCache) {
+    pool::configure_reservation_cache(cacheOptions(4));
+    pool_options options;
+    options.numaPolicy = numa_policy::Interleave;
+    const auto before = pool::get_reservation_cache_statistics();
+    delete pool::create(MB, pool_type::SingleThreaded, options);
+    delete pool::create(MB, pool_type::SingleThreaded, options);
+    const auto after = pool::get_reservation_cache_statistics();
+    EXPECT_EQ(before.hits, after.hits);
+    EXPECT_EQ(before.misses, after.misses);
+    EXPECT_EQ(0, after.reservations);
+}
+
+TEST_F(ReservationCache, ServesEveryPoolType) {
+    pool::configure_reservation_cache(cacheOptions(64));
+    for (const auto type : {pool_type::SingleThreaded, pool_type::ThreadSafe, pool_type::ThreadBuffered,
+                            pool_type::PerCpu, pool_type::PerThread, pool_type::Locked, pool_type::Recycling}) {
+        for (int i = 0; i < 3; ++i) {
+            auto* pool = pool::create(MB, type);
+            useMemory(pool->new_buffer(1000), 1000);
+            delete pool;
+        }
+    }
+    EXPECT_GT(pool::get_reservation_cache_statistics().hits, 0);
+}
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+
+using namespace memory_pool;
+
+using Reset = PoolTypeTest;
+
+TEST_P(Reset, ResetEmptiesPool) {
+    constexpr auto size = 1000;
+    auto* pool = pool::create(size, GetParam());
+    useMemory(pool->new_buffer(1), 1);
+    useMemory(pool->new_buffer(8, 8), 8);
+    EXPECT_GT(pool->get_size(), 0);
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(0, pool->get_alignment_fragmentation());
+    for (int i = 0; i < size; ++i)
+        useMemory(pool->new_buffer(1), 1);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(AllTypes, Reset, testing::Values(
+                             pool_type::SingleThreaded,
+                             pool_type::ThreadSafe,
+                             pool_type::PerThread,
+                             pool_type::Locked,
+                             pool_type::ThreadBuffered,
+                             pool_type::PerCpu),
+                         poolTypeParamName);
+
+using Rewind = PoolTypeTest;
+
+TEST_P(Rewind, RewindRestoresState) {
+    auto* pool = pool::create(1000, GetParam());
+    useMemory(pool->new_buffer(1), 1);
+    const auto marker = pool->mark();
+    const auto size = pool->get_size();
+    const auto fragmentation = pool->get_alignment_fragmentation();
+    auto* first = pool->new_buffer(8, 8);
+    useMemory(first, 8);
+    useMemory(pool->new_buffer(100), 100);
+    EXPECT_GT(pool->get_alignment_fragmentation(), fragmentation);
+    pool->rewind(marker);
+    EXPECT_EQ(size, pool->get_size());
+    EXPECT_EQ(fragmentation, pool->get_alignment_fragmentation());
+    EXPECT_EQ(first, pool->new_buffer(8, 8));
+    delete pool;
+}
+
+TEST_P(Rewind, RewindPastPositionThrows) {
+    auto* pool = pool::create(1000, GetParam());
+    useMemory(pool->new_buffer(10), 10);
+    const auto marker = pool->mark();
+    pool->reset();
+    EXPECT_THROW(pool->rewind(marker), std::invalid_argument);
+    delete pool;
+}
+
+TEST_P(Rewind, ScopeRewinds) {
+    auto* pool = pool::create(1000, GetParam());
+    useMemory(pool->new_buffer(10), 10);
+    for (int i = 0; i < 100; ++i) {
+        pool_scope outer(*pool);
+        useMemory(pool->new_buffer(5), 5);
+        {
+            pool_scope inner(*pool);
+            useMemory(pool->new_buffer(3), 3);
+            EXPECT_EQ(18, pool->get_size());
+        }
+        EXPECT_EQ(15, pool->get_size());
+    }
+    EXPECT_EQ(10, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Rewind, ScopeAfterResetDoesNothing) {
+    auto* pool = pool::create(1000, GetParam());
+    useMemory(pool->new_buffer(10), 10);
+    {
+        pool_scope scope(*pool);
+        useMemory(pool->new_buffer(5), 5);
+        pool->reset();
+        useMemory(pool->new_buffer(3), 3);
+    }
+    EXPECT_EQ(3, pool->get_size());
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(MarkerTypes, Rewind, stackPoolTypes, poolTypeParamName);
+
+TEST(Rewind, UnsupportedTypeThrows) {
+    auto* pool = pool::create(1000, pool_type::PerCpu);
+    EXPECT_THROW((void)pool->mark(), std::logic_error);
+    delete pool;
+}
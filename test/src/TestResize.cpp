@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "memory-pool/basic_pool.h"
+#include "TestUtils.h"
+#include <string>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+
+    pool_options growableOptions() {
+        pool_options options;
+        options.growable = true;
+        return options;
+    }
+}
+
+using Resize = PoolTypeTest;
+
+TEST_P(Resize, ExtendsLastAllocationInPlace) {
+    auto* pool = pool::create(MB, GetParam());
+    (void)pool->new_buffer(10);
+    auto* buffer = pool->new_buffer(100);
+    EXPECT_TRUE(pool->try_extend(buffer, 100, 1000));
+    EXPECT_EQ(1010, pool->get_size());
+    useMemory(buffer, 1000);
+    auto* next = pool->new_buffer(1);
+    EXPECT_EQ(static_cast<char*>(buffer) + 1000, next);
+    delete pool;
+}
+
+TEST_P(Resize, ExtendsAcrossCommittedPages) {
+    auto* pool = pool::create(64 * MB, GetParam());
+    auto* buffer = pool->new_buffer(100);
+    EXPECT_TRUE(pool->try_extend(buffer, 100, 40 * MB));
+    useMemory(buffer, 40 * MB);
+    EXPECT_GE(pool->get_committed_size(), 40 * MB);
+    delete pool;
+}
+
+TEST_P(Resize, DoesNotExtendEarlierAllocation) {
+    auto* pool = pool::create(MB, GetParam());
+    auto* first = pool->new_buffer(100);
+    (void)pool->new_buffer(100);
+    EXPECT_FALSE(pool->try_extend(first, 100, 200));
+    EXPECT_FALSE(pool->shrink(first, 100, 50));
+    EXPECT_EQ(200, pool->get_size());
+    delete pool;
+}
+
+TEST_P(Resize, DoesNotExtendPastCapacity) {
+    auto* pool = pool::create(1000, GetParam());
+    auto* buffer = pool->new_buffer(100);
+    EXPECT_FALSE(pool->try_extend(buffer, 100, 1001));
+    EXPECT_TRUE(pool->try_extend(buffer, 100, 1000));
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST_P(Resize, ShrinkGivesBytesBack) {
+    auto* pool = pool::create(MB, GetParam());
+    auto* buffer = pool->new_buffer(1000);
+    EXPECT_TRUE(pool->shrink(buffer, 1000, 10));
+    EXPECT_EQ(10, pool->get_size());
+    EXPECT_EQ(static_cast<char*>(buffer) + 10, pool->new_buffer(1));
+    delete pool;
+}
+
+TEST_P(Resize, RejectsWrongDirection) {
+    auto* pool = pool::create(MB, GetParam());
+    auto* buffer = pool->new_buffer(100);
+    EXPECT_THROW((void)pool->try_extend(buffer, 100, 50), std::invalid_argument);
+    EXPECT_THROW((void)pool->shrink(buffer, 100, 150), std::invalid_argument);
+    delete pool;
+}
+
+TEST_P(Resize, BufferAppendsInPlace) {
+    auto* pool = pool::create(MB, GetParam());
+    {
+        pool_buffer<int> buffer(*pool);
+        for (int i = 0; i < 10000; ++i) {
+            buffer.push_back(i);
+        }
+        // Each growth extended the same allocation, so nothing was copied or left behind.
+        EXPECT_EQ(buffer.get_capacity() * sizeof(int), pool->get_size());
+        for (int i = 0; i < 10000; ++i) {
+            ASSERT_EQ(i, buffer[i]);
+        }
+        buffer.shrink_to_fit();
+        EXPECT_EQ(10000, buffer.get_capacity());
+        EXPECT_EQ(10000 * sizeof(int), pool->get_size());
+    }
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Resize, stackPoolTypes, poolTypeParamName);
+
+TEST(Resize, BufferMovesWhenNotLast) {
+    auto* pool = pool::create(MB, pool_type::SingleThreaded);
+    {
+        pool_buffer<char> buffer(*pool, 16);
+        buffer.append("0123456789abcdef", 16);
+        auto* before = buffer.data();
+        (void)pool->new_buffer(1);
+        buffer.push_back('g');
+        EXPECT_NE(before, buffer.data());
+        EXPECT_EQ(32, buffer.get_capacity());
+        EXPECT_EQ("0123456789abcdefg", std::string(buffer.begin(), buffer.end()));
+    }
+    delete pool;
+}
+
+TEST(Resize, UnsupportedTypesNeverResize) {
+    for (const auto type : {pool_type::ThreadBuffered, pool_type::PerCpu, pool_type::Recycling}) {
+        auto* pool = pool::create(MB, type);
+        auto* buffer = pool->new_buffer(100);
+        EXPECT_FALSE(pool->try_extend(buffer, 100, 200));
+        {
+            pool_buffer<int> values(*pool);
+            for (int i = 0; i < 1000; ++i) {
+                values.push_back(i);
+            }
+            EXPECT_EQ(999, values[999]);
+        }
+        delete pool;
+    }
+}
+
+TEST(Resize, GrowableExtendsInCurrentSegment) {
+    for (const auto type : {pool_type::SingleThreaded, pool_type::ThreadSafe}) {
+        auto* pool = pool::create(4096, type, growableOptions());
+        auto* first = pool->new_buffer(3000);
+        auto* second = pool->new_buffer(3000); // Starts a new segment.
+        EXPECT_FALSE(pool->try_extend(first, 3000, 3001));
+        EXPECT_TRUE(pool->try_extend(second, 3000, 6000));
+        useMemory(second, 6000);
+        delete pool;
+    }
+}
+
+TEST(Resize, BasicPool) {
+    basic_pool<thread_safe> pool(4 * MB);
+    auto* buffer = pool.allocate(100);
+    EXPECT_TRUE(pool.try_extend(buffer, 100, 3 * MB));
+    useMemory(buffer, 3 * MB);
+    EXPECT_TRUE(pool.shrink(buffer, 3 * MB, 200));
+    EXPECT_EQ(200, pool.get_size());
+    EXPECT_FALSE(pool.try_extend(buffer, 100, 300));
+}
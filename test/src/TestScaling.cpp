@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "TestUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t allocationsPerThread = 200000;
+    constexpr size_t allocationSize = 16;
+
+    // Allocates from the pool on the given number of threads and returns allocations per second.
+    double measureThroughput(pool& pool, const int threadCount, const size_t size, const size_t alignment) {
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < threadCount; ++i) {
+            threads.emplace_back([&pool, size, alignment] {
+                for (size_t j = 0; j < allocationsPerThread; ++j)
+                    *static_cast<char*>(pool.new_buffer(size, alignment)) = 0;
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(threadCount * allocationsPerThread) / elapsed.count();
+    }
+
+    void reportScaling(const pool_type type, const char* name) {
+        for (const int threadCount : {1, 2, 4, 8, 16, 32}) {
+            auto* pool = pool::create(threadCount * allocationsPerThread * allocationSize, type);
+            const auto throughput = measureThroughput(*pool, threadCount, allocationSize, 1);
+            std::printf("%-10s %2d threads: %8.2f M allocations/s\n", name, threadCount, throughput / 1e6);
+            assertPoolFull(*pool);
+            delete pool;
+        }
+    }
+}
+
+TEST(Scaling, ThreadSafe) {
+    reportScaling(pool_type::ThreadSafe, "ThreadSafe");
+}
+
+TEST(Scaling, Locked) {
+    reportScaling(pool_type::Locked, "Locked");
+}
+
+TEST(Scaling, ThreadSafeAccountingExact) {
+    constexpr int threadCount = 8;
+    constexpr size_t size = 13;
+    constexpr size_t alignment = 8;
+    auto* pool = pool::create(threadCount * allocationsPerThread * (size + alignment), pool_type::ThreadSafe);
+    (void)measureThroughput(*pool, threadCount, size, alignment);
+    EXPECT_EQ(threadCount * allocationsPerThread * size + pool->get_alignment_fragmentation(), pool->get_size());
+    EXPECT_GT(pool->get_alignment_fragmentation(), 0);
+    delete pool;
+}
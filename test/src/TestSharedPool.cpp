@@ -0,0 +1,138 @@
+#ifndef _WIN32
+#include "gtest/gtest.h"
+#include "memory-pool/file_pool.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+    constexpr int childCount = 4;
+    constexpr int allocationsPerChild = 1000;
+    constexpr size_t allocationSize = 100;
+
+    // Runs f in a forked child, and returns the child's process ID. The child exits with 0 if f returns true.
+    template<typename F>
+    pid_t forkChild(F&& f) {
+        const auto pid = fork();
+        if (pid == 0) {
+            bool succeeded = false;
+            try {
+                succeeded = f();
+            } catch (...) {
+            }
+            _exit(succeeded ? 0 : 1);
+        }
+        return pid;
+    }
+
+    // Waits for a child and returns whether it succeeded.
+    bool waitForChild(const pid_t pid) {
+        int status;
+        return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    std::string uniqueName(const char* test) {
+        return "/memory_pool_test_" + std::to_string(getpid()) + "_" + test;
+    }
+}
+
+TEST(SharedPool, ForkedChildrenShareAnonymousPool) {
+    auto* pool = file_pool::open_shared("", 4 * MB);
+    EXPECT_TRUE(pool->is_new());
+    // Each child records the offsets of what it allocated here.
+    auto* offsets = pool->new_array<size_t>(childCount * allocationsPerChild, 0);
+    const auto sizeBefore = pool->get_size();
+
+    std::vector<pid_t> children;
+    for (int child = 0; child < childCount; ++child) {
+        children.push_back(forkChild([pool, offsets, child] {
+            for (int i = 0; i < allocationsPerChild; ++i) {
+                auto* buffer = pool->new_buffer(allocationSize);
+                std::memset(buffer, child + 1, allocationSize);
+                offsets[child * allocationsPerChild + i] = pool->to_offset(buffer);
+            }
+            return true;
+        }));
+    }
+    for (const auto pid : children) {
+        ASSERT_TRUE(waitForChild(pid));
+    }
+
+    // Every allocation went to a different place, and still holds what its child wrote.
+    EXPECT_EQ(sizeBefore + childCount * allocationsPerChild * allocationSize, pool->get_size());
+    for (int child = 0; child < childCount; ++child) {
+        for (int i = 0; i < allocationsPerChild; ++i) {
+            const auto offset = offsets[child * allocationsPerChild + i];
+            const auto* buffer = static_cast<unsigned char*>(pool->from_offset(offset));
+            for (size_t j = 0; j < allocationSize; ++j) {
+                ASSERT_EQ(child + 1, buffer[j]);
+            }
+        }
+    }
+    delete pool;
+}
+
+TEST(SharedPool, ProcessesAttachByName) {
+    const auto name = uniqueName("attach");
+    auto* pool = file_pool::open_shared(name, MB);
+    EXPECT_TRUE(pool->is_new());
+    (void)pool->new_buffer(10);
+
+    // The child opens the pool itself, so it may map it somewhere else.
+    const auto pid = forkChild([&name] {
+        auto* attached = file_pool::open_shared(name, MB);
+        const auto ok = !attached->is_new() && attached->get_size() == 10;
+        auto* message = static_cast<char*>(attached->new_buffer(6));
+        std::memcpy(message, "hello", 6);
+        attached->set_root(message);
+        delete attached;
+        return ok;
+    });
+    ASSERT_TRUE(waitForChild(pid));
+
+    ASSERT_NE(nullptr, pool->get_root());
+    EXPECT_STREQ("hello", static_cast<char*>(pool->get_root()));
+    EXPECT_EQ(16, pool->get_size());
+    delete pool;
+    file_pool::remove_shared(name);
+}
+
+TEST(SharedPool, FixedMappingSharesPointers) {
+    const auto name = uniqueName("fixed");
+    file_pool_options options;
+    options.mapping = file_mapping::Fixed;
+    auto* pool = file_pool::open_shared(name, MB, options);
+    auto* first = pool->new_object<int>(42);
+    pool->set_root(first);
+    delete pool;
+
+    const auto pid = forkChild([&name, &options, first] {
+        auto* attached = file_pool::open_shared(name, MB, options);
+        const auto ok = attached->get_root() == first && *first == 42;
+        delete attached;
+        return ok;
+    });
+    EXPECT_TRUE(waitForChild(pid));
+    file_pool::remove_shared(name);
+}
+
+TEST(SharedPool, RemovedNameStartsOver) {
+    const auto name = uniqueName("remove");
+    auto* pool = file_pool::open_shared(name, MB);
+    (void)pool->new_buffer(10);
+    file_pool::remove_shared(name);
+
+    auto* second = file_pool::open_shared(name, MB);
+    EXPECT_TRUE(second->is_new());
+    EXPECT_EQ(0, second->get_size());
+    EXPECT_EQ(10, pool->get_size());
+    delete second;
+    delete pool;
+    file_pool::remove_shared(name);
+}
+#endif
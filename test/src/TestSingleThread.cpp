@@ -138,15 +138,17 @@ TEST(SingleThread, TemplateAllocatorVectorConstrArgs2) {
     constexpr auto count = 10;
     auto* pool = pool::create(getAlignedSize<Foo>() * count, pool_type::SingleThreaded);
     allocator<Foo> a(pool);
-    std::vector<Foo, allocator<Foo>> vec(a);
-    vec.reserve(count);
-    for (int i = 0; i < count; ++i) {
-        const auto expectedX = 10 * i;
-        const auto expectedY = 20 * i;
-        vec.emplace_back(expectedX, expectedY);
-        EXPECT_EQ(expectedX, vec[i].x);
-        EXPECT_EQ(expectedY, vec[i].y);
-        useMemory(&vec[i], sizeof(Foo));
+    {
+        std::vector<Foo, allocator<Foo>> vec(a);
+        vec.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const auto expectedX = 10 * i;
+            const auto expectedY = 20 * i;
+            vec.emplace_back(expectedX, expectedY);
+            EXPECT_EQ(expectedX, vec[i].x);
+            EXPECT_EQ(expectedY, vec[i].y);
+            useMemory(&vec[i], sizeof(Foo));
+        }
     }
     delete pool;
 }
@@ -154,14 +156,16 @@ TEST(SingleThread, TemplateAllocatorVectorConstrArgs2) {
 TEST(SingleThread, AssignVector) {
     auto* pool = pool::create(123);
     allocator<int> a(pool);
-    std::vector<int, allocator<int>> v1(a);
-    v1.push_back(1);
-    const auto usage1 = a.get_pool()->get_size();
-
-    std::vector<int, allocator<int>> v2 = v1;
-    v2.push_back(2);
-    const auto usage2 = a.get_pool()->get_size();
-    EXPECT_GT(usage2, usage1);
+    {
+        std::vector<int, allocator<int>> v1(a);
+        v1.push_back(1);
+        const auto usage1 = a.get_pool()->get_size();
+
+        std::vector<int, allocator<int>> v2 = v1;
+        v2.push_back(2);
+        const auto usage2 = a.get_pool()->get_size();
+        EXPECT_GT(usage2, usage1);
+    }
 
     delete pool;
 }
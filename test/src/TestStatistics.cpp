@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace memory_pool;
+
+using Peak = PoolTypeTest;
+
+TEST_P(Peak, PeakSurvivesRewind) {
+    auto* pool = pool::create(1000, GetParam());
+    EXPECT_EQ(0, pool->get_peak_size());
+    useMemory(pool->new_buffer(100), 100);
+    EXPECT_EQ(100, pool->get_peak_size());
+    pool->reset();
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(100, pool->get_peak_size());
+    useMemory(pool->new_buffer(50), 50);
+    EXPECT_EQ(100, pool->get_peak_size());
+    const auto marker = pool->mark();
+    useMemory(pool->new_buffer(100), 100);
+    pool->rewind(marker);
+    EXPECT_EQ(150, pool->get_peak_size());
+    delete pool;
+}
+
+TEST_P(Peak, StatisticsMatchGetters) {
+    auto* pool = pool::create(1000, GetParam());
+    useMemory(pool->new_buffer(1), 1);
+    useMemory(pool->new_buffer(8, 8), 8);
+    const auto statistics = pool->get_statistics();
+    EXPECT_EQ(pool->get_capacity(), statistics.capacity);
+    EXPECT_EQ(pool->get_size(), statistics.size);
+    EXPECT_EQ(pool->get_alignment_fragmentation(), statistics.alignmentFragmentation);
+    EXPECT_EQ(pool->get_committed_size(), statistics.committedSize);
+    EXPECT_EQ(pool->get_peak_size(), statistics.peakSize);
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(Types, Peak, stackPoolTypes, poolTypeParamName);
+
+TEST(Statistics, PerThreadCoversEveryThread) {
+    auto* pool = pool::create(1000, pool_type::PerThread);
+    constexpr int threadCount = 4;
+    std::atomic<int> ready = 0;
+    std::atomic<bool> done = false;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&, i] {
+            useMemory(pool->new_buffer(10 * (i + 1)), 10 * (i + 1));
+            ++ready;
+            while (!done) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (ready < threadCount) {
+        std::this_thread::yield();
+    }
+
+    const auto statistics = pool->get_statistics();
+    EXPECT_EQ(threadCount * 1000, statistics.capacity);
+    EXPECT_EQ(10 + 20 + 30 + 40, statistics.size);
+    EXPECT_EQ(10 + 20 + 30 + 40, statistics.peakSize);
+    EXPECT_GT(statistics.committedSize, 0);
+    ASSERT_EQ(threadCount, statistics.threads.size());
+    for (int i = 0; i < threadCount; ++i) {
+        const auto id = threads[i].get_id();
+        const auto it = std::find_if(statistics.threads.begin(), statistics.threads.end(),
+                                     [id](const thread_usage& usage) { return usage.threadId == id; });
+        ASSERT_NE(statistics.threads.end(), it);
+        EXPECT_EQ(10 * (i + 1), it->size);
+        EXPECT_EQ(1000, it->capacity);
+    }
+
+    done = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Exited threads' pools are freed.
+    EXPECT_TRUE(pool->get_statistics().threads.empty());
+    delete pool;
+}
+
+TEST(Statistics, PerThreadGettersDoNotCreatePool) {
+    auto* pool = pool::create(1000, pool_type::PerThread);
+    EXPECT_EQ(0, pool->get_size());
+    EXPECT_EQ(1000, pool->get_capacity());
+    EXPECT_EQ(0, pool->get_committed_size());
+    EXPECT_TRUE(pool->get_statistics().threads.empty());
+    delete pool;
+}
+
+TEST(Statistics, ReadWhileThreadsComeAndGo) {
+    auto* pool = pool::create(1 << 20, pool_type::PerThread);
+    std::atomic<bool> done = false;
+    std::thread monitor([&] {
+        while (!done) {
+            const auto statistics = pool->get_statistics();
+            EXPECT_LE(statistics.size, statistics.capacity);
+        }
+    });
+    for (int round = 0; round < 50; ++round) {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([pool] {
+                for (int j = 0; j < 100; ++j) {
+                    useMemory(pool->new_buffer(64, 8), 64);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    done = true;
+    monitor.join();
+    delete pool;
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "TestUtils.h"
+#include <atomic>
+#include <stdexcept>
 #include <thread>
 
 using namespace memory_pool;
@@ -76,3 +78,121 @@ TEST(ThreadSafe, TryRaceBigPerThread) {
     ASSERT_EQ(0, pool->get_size());
     delete pool;
 }
+
+TEST(ThreadSafe, TryRaceThreadBuffered) {
+    pool_options options;
+    options.threadBufferSize = 64;
+    auto* pool = pool::create(4096, pool_type::ThreadBuffered, options);
+    std::thread t1([pool] {
+        for (int i = 0; i < 1000; i++)
+            useMemory(pool->new_buffer(1), 1);
+    });
+    std::thread t2([pool] {
+        for (int i = 0; i < 1000; i++)
+            useMemory(pool->new_buffer(1), 1);
+    });
+    t1.join();
+    t2.join();
+    EXPECT_EQ(2000, pool->get_size());
+    EXPECT_EQ(0, pool->get_alignment_fragmentation());
+    delete pool;
+}
+
+TEST(ThreadSafe, ThreadBufferedFillsCapacity) {
+    pool_options options;
+    options.threadBufferSize = 64;
+    auto* pool = pool::create(1000, pool_type::ThreadBuffered, options);
+    for (int i = 0; i < 1000; i++)
+        useMemory(pool->new_buffer(1), 1);
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST(ThreadSafe, ThreadBufferedSizeWhileAllocating) {
+    pool_options options;
+    options.threadBufferSize = 256;
+    auto* pool = pool::create(1024 * 1024, pool_type::ThreadBuffered, options);
+    std::atomic<bool> done = false;
+    std::thread reader([pool, &done] {
+        while (!done.load()) {
+            // Would wrap around if a buffer's unused bytes were counted before the shared pool's size covered them.
+            ASSERT_LE(pool->get_size(), pool->get_capacity());
+        }
+    });
+    // Short-lived threads leave partly used buffers behind for the next ones to take over.
+    for (int t = 0; t < 200; t++) {
+        std::thread([pool] {
+            for (int i = 0; i < 100; i++)
+                useMemory(pool->new_buffer(3), 3);
+        }).join();
+    }
+    done = true;
+    reader.join();
+    EXPECT_GE(pool->get_size(), 200 * 100 * 3);
+    delete pool;
+}
+
+TEST(ThreadSafe, ThreadBufferedCombinesStatistics) {
+    const auto MB = 1024 * 1024;
+    pool_options options;
+    options.threadBufferSize = MB;
+    auto* pool = pool::create(100 * MB, pool_type::ThreadBuffered, options);
+    std::thread t1([pool] {
+        useMemory(pool->new_buffer(1), 1);
+        useMemory(pool->new_buffer(8, 8), 8);
+    });
+    t1.join();
+    std::thread t2([pool] {
+        useMemory(pool->new_buffer(3), 3);
+        useMemory(pool->new_buffer(4, 4), 4);
+    });
+    t2.join();
+    EXPECT_EQ(7 + 1, pool->get_alignment_fragmentation());
+    EXPECT_EQ(1 + 8 + 3 + 4 + pool->get_alignment_fragmentation(), pool->get_size());
+    useMemory(pool->new_buffer(2 * MB), 2 * MB);
+    EXPECT_EQ(1 + 8 + 3 + 4 + 8 + 2 * MB, pool->get_size());
+    delete pool;
+}
+
+TEST(ThreadSafe, TryRacePerCpu) {
+    pool_options options;
+    options.cpuShardCount = 4;
+    auto* pool = pool::create(2000, pool_type::PerCpu, options);
+    EXPECT_EQ(2000, pool->get_capacity());
+    std::thread t1([pool] {
+        for (int i = 0; i < 1000; i++)
+            useMemory(pool->new_buffer(1), 1);
+    });
+    std::thread t2([pool] {
+        for (int i = 0; i < 1000; i++)
+            useMemory(pool->new_buffer(1), 1);
+    });
+    t1.join();
+    t2.join();
+    assertPoolFull(*pool);
+    delete pool;
+}
+
+TEST(ThreadSafe, PerCpuAllocationMustFitInShard) {
+    pool_options options;
+    options.cpuShardCount = 4;
+    auto* pool = pool::create(4000, pool_type::PerCpu, options);
+    useMemory(pool->new_buffer(1000), 1000);
+    EXPECT_THROW((void)pool->new_buffer(1001), std::invalid_argument);
+    EXPECT_EQ(1000, pool->get_size());
+    delete pool;
+}
+
+TEST(ThreadSafe, PerCpuManyShortLivedThreads) {
+    constexpr int threadCount = 200;
+    auto* pool = pool::create(1024 * 1024, pool_type::PerCpu);
+    for (int i = 0; i < threadCount; i++) {
+        std::thread t([pool] {
+            useMemory(pool->new_buffer(10), 10);
+            useMemory(pool->new_buffer(8, 8), 8);
+        });
+        t.join();
+    }
+    EXPECT_EQ(threadCount * 18 + pool->get_alignment_fragmentation(), pool->get_size());
+    delete pool;
+}
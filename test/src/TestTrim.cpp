@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include "memory-pool/memory_pool.h"
+#include "TestUtils.h"
+
+using namespace memory_pool;
+
+namespace {
+    constexpr size_t MB = 1024 * 1024;
+}
+
+using Trim = PoolTypeTest;
+
+TEST_P(Trim, ReportsCommittedAndResident) {
+    auto* pool = pool::create(64 * MB, GetParam());
+    EXPECT_EQ(0, pool->get_resident_size());
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    EXPECT_EQ(8 * MB, pool->get_size());
+    EXPECT_GE(pool->get_committed_size(), 8 * MB);
+    EXPECT_GE(pool->get_resident_size(), 8 * MB);
+    EXPECT_LE(pool->get_resident_size(), pool->get_committed_size());
+    delete pool;
+}
+
+TEST_P(Trim, TrimAfterResetReleasesMemory) {
+    auto* pool = pool::create(64 * MB, GetParam());
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    const auto committed = pool->get_committed_size();
+    pool->reset();
+    EXPECT_GE(pool->trim(), 8 * MB);
+    EXPECT_EQ(0, pool->get_resident_size());
+    EXPECT_EQ(committed, pool->get_committed_size());
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    delete pool;
+}
+
+TEST_P(Trim, TrimKeepsMemoryInUse) {
+    auto* pool = pool::create(64 * MB, GetParam());
+    auto* data = static_cast<char*>(pool->new_buffer(MB + 1));
+    useMemory(data, MB + 1);
+    data[MB] = 42;
+    useMemory(pool->new_buffer(4 * MB), 4 * MB);
+    pool->rewind(pool_marker{MB + 1, 0});
+    (void)pool->trim();
+    EXPECT_EQ(42, data[MB]);
+    EXPECT_GE(pool->get_resident_size(), MB + 1);
+    EXPECT_LT(pool->get_resident_size(), 2 * MB);
+    delete pool;
+}
+
+TEST_P(Trim, WarmReserveStaysResident) {
+    pool_options options;
+    options.warmReserveBytes = 2 * MB;
+    options.trimOnRewind = true;
+    auto* pool = pool::create(64 * MB, GetParam(), options);
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    pool->reset();
+    EXPECT_EQ(2 * MB, pool->get_resident_size());
+    delete pool;
+}
+
+TEST_P(Trim, FreePolicyKeepsPoolUsable) {
+    pool_options options;
+    options.decommitPolicy = decommit_policy::Free;
+    auto* pool = pool::create(64 * MB, GetParam(), options);
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    pool->reset();
+    EXPECT_GE(pool->trim(), 8 * MB);
+    useMemory(pool->new_buffer(8 * MB), 8 * MB);
+    delete pool;
+}
+
+INSTANTIATE_TEST_SUITE_P(MarkerTypes, Trim, stackPoolTypes, poolTypeParamName);
@@ -21,3 +21,27 @@ void assertPoolFull(pool& pool) {
         return;
     }
 }
+
+const char* poolTypeName(const pool_type type) {
+    switch (type) {
+        case pool_type::SingleThreaded:
+            return "SingleThreaded";
+        case pool_type::ThreadSafe:
+            return "ThreadSafe";
+        case pool_type::PerThread:
+            return "PerThread";
+        case pool_type::Locked:
+            return "Locked";
+        case pool_type::ThreadBuffered:
+            return "ThreadBuffered";
+        case pool_type::PerCpu:
+            return "PerCpu";
+        case pool_type::Recycling:
+            return "Recycling";
+    }
+    return "Unknown";
+}
+
+std::string poolTypeParamName(const testing::TestParamInfo<pool_type>& info) {
+    return poolTypeName(info.param);
+}